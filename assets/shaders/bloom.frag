@@ -6,8 +6,22 @@ in vec2 frag_uv;
 uniform sampler2D color_texture;
 uniform sampler2D bright_color_texture;
 uniform float strength;
+// Part of the sources that holds the image, with dynamic resolution.
+uniform vec2 uv_scale;
+// Sharpening applied while upscaling, 0.0 is plain bilinear.
+uniform float sharpness;
 
 void main() {
-    vec3 bloom = texture(bright_color_texture, frag_uv).rgb;
-    color = vec4(texture(color_texture, frag_uv).rgb + bloom * strength, 1.0);
+    vec2 uv = frag_uv * uv_scale;
+    vec3 center = texture(color_texture, uv).rgb;
+    if (sharpness > 0.0) {
+        vec2 texel = 1.0 / vec2(textureSize(color_texture, 0));
+        vec3 neighbours = texture(color_texture, uv + vec2(texel.x, 0.0)).rgb
+                        + texture(color_texture, uv - vec2(texel.x, 0.0)).rgb
+                        + texture(color_texture, uv + vec2(0.0, texel.y)).rgb
+                        + texture(color_texture, uv - vec2(0.0, texel.y)).rgb;
+        center = max(center + (center * 4.0 - neighbours) * 0.25 * sharpness, vec3(0.0));
+    }
+    vec3 bloom = texture(bright_color_texture, uv).rgb;
+    color = vec4(center + bloom * strength, 1.0);
 }
@@ -0,0 +1,41 @@
+#version 430 core
+
+layout(location = 0) out vec4 color;
+in vec2 frag_uv;
+
+uniform sampler2D color_texture;
+// Part of the source that holds the image, with dynamic resolution.
+uniform vec2 uv_scale;
+
+vec3 sample_source(vec2 uv, vec2 texel) {
+    return texture(color_texture, clamp(uv, 0.5 * texel, uv_scale - 0.5 * texel)).rgb;
+}
+
+// 13 tap downsample, from "Next generation post processing in Call of Duty: Advanced Warfare".
+void main() {
+    vec2 texel = 1.0 / vec2(textureSize(color_texture, 0));
+    vec2 uv = frag_uv * uv_scale;
+
+    vec3 a = sample_source(uv + texel * vec2(-2.0, 2.0), texel);
+    vec3 b = sample_source(uv + texel * vec2(0.0, 2.0), texel);
+    vec3 c = sample_source(uv + texel * vec2(2.0, 2.0), texel);
+
+    vec3 d = sample_source(uv + texel * vec2(-2.0, 0.0), texel);
+    vec3 e = sample_source(uv, texel);
+    vec3 f = sample_source(uv + texel * vec2(2.0, 0.0), texel);
+
+    vec3 g = sample_source(uv + texel * vec2(-2.0, -2.0), texel);
+    vec3 h = sample_source(uv + texel * vec2(0.0, -2.0), texel);
+    vec3 i = sample_source(uv + texel * vec2(2.0, -2.0), texel);
+
+    vec3 j = sample_source(uv + texel * vec2(-1.0, 1.0), texel);
+    vec3 k = sample_source(uv + texel * vec2(1.0, 1.0), texel);
+    vec3 l = sample_source(uv + texel * vec2(-1.0, -1.0), texel);
+    vec3 m = sample_source(uv + texel * vec2(1.0, -1.0), texel);
+
+    vec3 result = e * 0.125;
+    result += (a + c + g + i) * 0.03125;
+    result += (b + d + f + h) * 0.0625;
+    result += (j + k + l + m) * 0.125;
+    color = vec4(result, 1.0);
+}
@@ -0,0 +1,31 @@
+#version 430 core
+
+layout(location = 0) out vec4 color;
+in vec2 frag_uv;
+
+uniform sampler2D color_texture;
+uniform float radius;
+// Part of the source that holds the image, with dynamic resolution.
+uniform vec2 uv_scale;
+
+vec3 sample_source(vec2 uv, vec2 texel) {
+    return texture(color_texture, clamp(uv, 0.5 * texel, uv_scale - 0.5 * texel)).rgb;
+}
+
+// 3x3 tent filter, blended additively onto the next larger level.
+void main() {
+    vec2 texel = 1.0 / vec2(textureSize(color_texture, 0));
+    vec2 offset = radius * texel;
+    vec2 uv = frag_uv * uv_scale;
+
+    vec3 result = sample_source(uv, texel) * 4.0;
+    result += sample_source(uv + offset * vec2(-1.0, 0.0), texel) * 2.0;
+    result += sample_source(uv + offset * vec2(1.0, 0.0), texel) * 2.0;
+    result += sample_source(uv + offset * vec2(0.0, -1.0), texel) * 2.0;
+    result += sample_source(uv + offset * vec2(0.0, 1.0), texel) * 2.0;
+    result += sample_source(uv + offset * vec2(-1.0, -1.0), texel);
+    result += sample_source(uv + offset * vec2(1.0, -1.0), texel);
+    result += sample_source(uv + offset * vec2(-1.0, 1.0), texel);
+    result += sample_source(uv + offset * vec2(1.0, 1.0), texel);
+    color = vec4(result / 16.0, 1.0);
+}
@@ -1,7 +1,14 @@
 #version 430 core
 
+// Depth pre-pass and colour pass must produce identical depth.
+invariant gl_Position;
+
 uniform mat4 model_view_projection;
-layout(location = 0) in vec3 position;
+// Quantized positions are fractions of the mesh bounds.
+uniform vec3 position_offset;
+uniform vec3 position_scale;
+layout(location = 0) in vec3 packed_position;
 void main() {
+    vec3 position = position_offset + position_scale * packed_position;
     gl_Position = model_view_projection * vec4(position, 1.0);
 }
@@ -6,10 +6,11 @@ in vec2 frag_uv;
 
 uniform sampler2DMS color_texture;
 uniform sampler2DMS depth_texture;
+uniform vec2 uv_scale;
 
 void main() {
     vec2 texture_size = textureSize(color_texture);
-    ivec2 pixel_uv = ivec2(floor(texture_size * frag_uv));
+    ivec2 pixel_uv = ivec2(floor(texture_size * uv_scale * frag_uv));
     vec3 average_color = vec3(0.0, 0.0, 0.0);
     for (int i = 0; i < 4; ++i) {
         average_color += texelFetch(color_texture, pixel_uv, i).rgb;
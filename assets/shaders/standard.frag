@@ -89,7 +89,9 @@ float fog_attenuation(const float dist, const float factor);
 void main() {
     vec3 normal = fragment.normal;
 
-    vec3 normal_from_map = texture(material.normal_map, fragment.uv).rgb * 2.0 - vec3(1.0);
+    // Z is rebuilt from X and Y, so two channel (BC5) normal maps work too.
+    vec3 normal_from_map = vec3(texture(material.normal_map, fragment.uv).rg * 2.0 - vec2(1.0), 0.0);
+    normal_from_map.z = sqrt(max(1.0 - dot(normal_from_map.xy, normal_from_map.xy), 0.0));
     normal_from_map = normalize(fragment.tbn * normal_from_map);
 
     float amount = texture(material.normal_map, fragment.uv).a;
@@ -1,5 +1,8 @@
 #version 430 core
 
+// Depth pre-pass and colour pass must produce identical depth.
+invariant gl_Position;
+
 struct Fragment {
     vec3 position;
     vec3 normal;
@@ -31,14 +34,32 @@ uniform mat4[2] depth_bias_model_view_projections;
 uniform mat4 model;
 uniform mat4 model_view_projection;
 uniform mat3 normal_matrix;
-layout(location = 0) in vec3 position;
-layout(location = 1) in vec3 normal;
-layout(location = 2) in vec3 tangent;
+// Quantized positions are fractions of the mesh bounds.
+uniform vec3 position_offset;
+uniform vec3 position_scale;
+uniform bool octahedral;
+layout(location = 0) in vec3 packed_position;
+layout(location = 1) in vec3 packed_normal;
+layout(location = 2) in vec3 packed_tangent;
 layout(location = 3) in vec2 uv;
 layout(location = 4) in float weight;
 out Fragment fragment;
 
+/** Normals and tangents are stored as is, or folded on an octahedron in two components. */
+vec3 decode_direction(vec3 direction) {
+    if (!octahedral) {
+        return direction;
+    }
+    vec3 n = vec3(direction.xy, 1.0 - abs(direction.x) - abs(direction.y));
+    float t = max(-n.z, 0.0);
+    n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+    return normalize(n);
+}
+
 void main() {
+    vec3 position = position_offset + position_scale * packed_position;
+    vec3 normal = decode_direction(packed_normal);
+    vec3 tangent = decode_direction(packed_tangent);
     vec3 T = normalize(vec3(model * vec4(tangent, 0.0)));
     vec3 N = normalize(normal_matrix * normal);
     T = normalize(T - dot(T, N) * N);
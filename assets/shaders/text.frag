@@ -0,0 +1,21 @@
+#version 430 core
+
+in vec2 fragment_uv;
+in vec4 fragment_color;
+layout(location = 0) out vec4 color;
+
+uniform sampler2D atlas;
+// Red holds signed distance, 0.5 at the glyph edge.
+uniform bool distance_field;
+
+void main() {
+    vec4 texel = texture(atlas, fragment_uv);
+    if (distance_field) {
+        // Antialias over about one pixel, whatever the scale.
+        float width = max(fwidth(texel.r), 1e-4);
+        float coverage = smoothstep(0.5 - width, 0.5 + width, texel.r);
+        color = vec4(fragment_color.rgb, coverage * fragment_color.a);
+    } else {
+        color = vec4(texel.rgb * fragment_color.rgb, texel.a * fragment_color.a);
+    }
+}
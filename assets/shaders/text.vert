@@ -0,0 +1,14 @@
+#version 430 core
+
+uniform mat4 view_projection;
+layout(location = 0) in vec3 position;
+layout(location = 1) in vec2 uv;
+layout(location = 2) in vec4 color;
+out vec2 fragment_uv;
+out vec4 fragment_color;
+
+void main() {
+    fragment_uv = uv;
+    fragment_color = color;
+    gl_Position = view_projection * vec4(position, 1.0);
+}
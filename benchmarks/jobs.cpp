@@ -0,0 +1,43 @@
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+#include <mos/core/jobs.hpp>
+#include "measure.hpp"
+
+using namespace mos;
+
+int main() {
+  std::printf("%zu workers\n", Jobs::workers());
+
+  // Scheduling overhead, empty jobs joined in batches like a frame's passes.
+  const int batches = 1000;
+  const int batch = 64;
+  std::atomic_int sink{0};
+  const double empty = measure([&]() {
+    for (int b = 0; b < batches; b++) {
+      JobCounter counter;
+      for (int i = 0; i < batch; i++) {
+        Jobs::run([&]() { sink.fetch_add(1, std::memory_order_relaxed); }, counter);
+      }
+      Jobs::wait(counter);
+    }
+  });
+  std::printf("empty jobs: %.0f per second, %.2f us each\n",
+              batches * batch / empty, empty / (batches * batch) * 1e6);
+
+  // Throughput against a serial loop, for a few grain sizes.
+  std::vector<float> values(1 << 22);
+  const auto work = [&](const size_t begin, const size_t end) {
+    for (size_t i = begin; i < end; i++) {
+      values[i] = std::sqrt(float(i)) * std::sin(float(i));
+    }
+  };
+  const double serial = measure([&]() { work(0, values.size()); });
+  std::printf("serial: %.2f ms\n", serial * 1e3);
+  for (const size_t grain : {size_t(256), size_t(4096), size_t(65536)}) {
+    const double parallel = measure([&]() { Jobs::parallel_for(0, values.size(), grain, work); });
+    std::printf("parallel_for grain %zu: %.2f ms, %.1fx\n", grain, parallel * 1e3, serial / parallel);
+  }
+  return 0;
+}
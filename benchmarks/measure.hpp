@@ -0,0 +1,16 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+
+/** Seconds taken by function, best of a few runs. */
+template<class Function>
+double measure(const Function &function) {
+  using Clock = std::chrono::steady_clock;
+  double best = 1e9;
+  for (int run = 0; run < 5; run++) {
+    const auto start = Clock::now();
+    function();
+    best = std::min(best, std::chrono::duration<double>(Clock::now() - start).count());
+  }
+  return best;
+}
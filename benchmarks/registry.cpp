@@ -0,0 +1,92 @@
+#include <cstdio>
+#include <random>
+#include <unordered_map>
+#include <vector>
+#include <mos/core/registry.hpp>
+#include "measure.hpp"
+
+using namespace mos;
+
+/** What the renderer looks up for a draw, by resource id. */
+struct Draw {
+  unsigned int mesh;
+  unsigned int albedo;
+  unsigned int normal;
+};
+
+/** Stands in for a vertex array or texture object. */
+struct Resource {
+  unsigned int name;
+  uint64_t frame;
+};
+
+int main() {
+  // Meshes and textures take ids from one counter, like Mesh::id() and Texture::id().
+  const int meshes = 4000;
+  const int textures = 8000;
+  std::vector<unsigned int> mesh_ids;
+  std::vector<unsigned int> texture_ids;
+  for (unsigned int id = 1; mesh_ids.size() < meshes || texture_ids.size() < textures; id++) {
+    if (id % 3 == 0 && mesh_ids.size() < meshes) {
+      mesh_ids.push_back(id);
+    } else if (texture_ids.size() < textures) {
+      texture_ids.push_back(id);
+    }
+  }
+
+  std::mt19937 random(1);
+  const int draws_per_frame = 10000;
+  std::vector<Draw> draws;
+  for (int i = 0; i < draws_per_frame; i++) {
+    draws.push_back(Draw{mesh_ids[random() % mesh_ids.size()],
+                         texture_ids[random() % texture_ids.size()],
+                         texture_ids[random() % texture_ids.size()]});
+  }
+
+  Registry<Resource> registry_meshes;
+  Registry<Resource> registry_textures;
+  std::unordered_map<unsigned int, Resource> map_meshes;
+  std::unordered_map<unsigned int, Resource> map_textures;
+  for (const auto id : mesh_ids) {
+    registry_meshes.insert(id, Resource{id, 0});
+    map_meshes.insert({id, Resource{id, 0}});
+  }
+  for (const auto id : texture_ids) {
+    registry_textures.insert(id, Resource{id, 0});
+    map_textures.insert({id, Resource{id, 0}});
+  }
+
+  // Each draw binds its vertex array and two textures, and marks them used.
+  const int frames = 100;
+  unsigned int sink = 0;
+  const double registry = measure([&]() {
+    for (int frame = 0; frame < frames; frame++) {
+      for (const auto &draw : draws) {
+        for (auto *resource : {registry_meshes.find(draw.mesh),
+                               registry_textures.find(draw.albedo),
+                               registry_textures.find(draw.normal)}) {
+          resource->frame = uint64_t(frame);
+          sink += resource->name;
+        }
+      }
+    }
+  });
+  const double map = measure([&]() {
+    for (int frame = 0; frame < frames; frame++) {
+      for (const auto &draw : draws) {
+        for (auto *resource : {&map_meshes.find(draw.mesh)->second,
+                               &map_textures.find(draw.albedo)->second,
+                               &map_textures.find(draw.normal)->second}) {
+          resource->frame = uint64_t(frame);
+          sink += resource->name;
+        }
+      }
+    }
+  });
+
+  const double submitted = double(frames) * draws_per_frame;
+  std::printf("registry: %.1f ns per draw\n", registry / submitted * 1e9);
+  std::printf("unordered_map: %.1f ns per draw\n", map / submitted * 1e9);
+  std::printf("%.2fx (%u)\n", map / registry, sink);
+  return 0;
+}
@@ -2,6 +2,8 @@
 #include <map>
 #include <memory>
 #include <unordered_map>
+#include <vector>
+#include <string>
 #include <mos/aud/buffer.hpp>
 #include <mos/aud/stream.hpp>
 
@@ -15,13 +17,21 @@ public:
   std::unordered_map<std::string, SharedBuffer>;
   using BufferPair = std::pair<std::string, SharedBuffer>;
 
-  explicit Assets(const std::string &directory = "assets/");
+  /**
+   * @param directory Root of the audio assets.
+   * @param cache_directory Where decoded PCM is cached, empty disables the cache.
+   */
+  explicit Assets(const std::string &directory = "assets/",
+                  const std::string &cache_directory = "");
   Assets(const Assets &assets) = delete;
   ~Assets() = default;
 
   /** Loads an *.ogg file into a buffer and caches it. */
   SharedBuffer audio_buffer(const std::string &path);
 
+  /** Load and decode several *.ogg files in parallel. */
+  void preload(const std::vector<std::string> &paths);
+
   /** Remove unused buffers. */
   void clear_unused();
 
@@ -30,6 +40,7 @@ public:
 
 private:
   const std::string directory_;
+  const std::string cache_directory_;
   BufferMap buffers_;
 };
 }
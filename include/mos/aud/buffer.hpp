@@ -26,13 +26,19 @@ public:
   /** Empty buffer constructor. */
   explicit Buffer(const int channels = 1);
 
-  /** Construct from *.ogg file. */
-  explicit Buffer(const std::string &path);
+  /**
+   * Construct from *.ogg file.
+   * @param cache_directory If not empty, decoded samples are stored there,
+   * keyed by a hash of the file content, and reused on later loads.
+   */
+  explicit Buffer(const std::string &path,
+                  const std::string &cache_directory = "");
 
   ~Buffer() = default;
 
   /** Load shared buffer. */
-  static SharedBuffer load(const std::string &path);
+  static SharedBuffer load(const std::string &path,
+                           const std::string &cache_directory = "");
 
   Samples::const_iterator begin() const;
 
@@ -0,0 +1,67 @@
+#pragma once
+#include <vector>
+#include <optional>
+#include <unordered_map>
+#include <mos/aud/scene.hpp>
+#include <mos/sim/box.hpp>
+#include <mos/sim/navmesh.hpp>
+
+namespace mos {
+namespace aud {
+
+/**
+ * Computes Source::obstructed by casting rays from the listener to playing
+ * sources. A fixed number of rays is cast per frame, round robin over the
+ * sources, and the results are smoothed over time. aud::Renderer applies
+ * obstructed without further smoothing.
+ */
+class Obstruction final {
+public:
+  /**
+   * @param boxes Occluding boxes.
+   * @param rays_per_frame Maximum number of rays cast each update.
+   * @param smoothing How fast obstruction approaches its target, per second.
+   */
+  explicit Obstruction(const std::vector<sim::Box> &boxes,
+                       const size_t rays_per_frame = 32,
+                       const float smoothing = 8.0f);
+
+  /** Use triangles of a navigation mesh as occluders. */
+  explicit Obstruction(const sim::Navmesh &navmesh,
+                       const size_t rays_per_frame = 32,
+                       const float smoothing = 8.0f);
+
+  /** Cast this frame's rays and write obstructed values into the scene. */
+  void update(Scene &scene, const float dt);
+
+  /** Maximum number of rays cast each update. */
+  size_t rays_per_frame;
+
+  /** How fast obstruction approaches its target, per second. */
+  float smoothing;
+
+private:
+  struct Entry {
+    float target;
+    unsigned int frame;
+  };
+
+  struct Ray {
+    glm::vec3 end;
+    unsigned int id;
+    bool hit;
+  };
+
+  bool occluded(const glm::vec3 &start, const glm::vec3 &end) const;
+
+  std::vector<sim::Box> boxes_;
+  std::optional<sim::Navmesh> navmesh_;
+
+  std::vector<Source *> sources_;
+  std::vector<Ray> rays_;
+  std::unordered_map<unsigned int, Entry> entries_;
+  size_t cursor_;
+  unsigned int frame_;
+};
+}
+}
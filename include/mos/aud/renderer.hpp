@@ -2,6 +2,9 @@
 #include <unordered_map>
 #include <memory>
 #include <thread>
+#include <vector>
+#include <array>
+#include <chrono>
 
 #include <AL/al.h>
 #include <AL/alc.h>
@@ -16,10 +19,15 @@
 namespace mos {
 namespace aud {
 
-/** OpenAL audio system. */
+/**
+ * OpenAL audio system. Keeps a fixed pool of voices, only the most
+ * important and audible sources are bound to one. The rest are virtualized
+ * and resume from their tracked play position when a voice frees up.
+ */
 class Renderer final {
 public:
-  Renderer();
+  /** @param max_voices Size of the voice pool, clamped to what the device supports. */
+  explicit Renderer(const int max_voices = 32);
 
   Renderer(const Renderer &audio) = delete;
 
@@ -34,15 +42,74 @@ public:
   /** Clear buffers */
   void clear();
 
+  /** Number of voices in the pool. */
+  size_t voices() const;
+
+  /** Number of sources currently bound to a voice. */
+  size_t active_voices() const;
+
 private:
+  /** Logical source state, kept while the source is virtual. */
+  struct Channel {
+    /** Voice the source is bound to, zero when virtualized. */
+    ALuint voice{0};
+    /** Play position in seconds, tracked while virtualized. */
+    float offset{0.0f};
+    /** Resume from offset on next bind. */
+    bool resume{false};
+    /** Obstruction filter gains, from Source::obstructed. */
+    float gain{1.0f};
+    float gain_hf{1.0f};
+    /** Selected for a voice this frame. */
+    bool audible{false};
+    /** Last frame the source was in the scene. */
+    unsigned int frame{0};
+    /** AL buffer bound to the voice. */
+    ALuint buffer{0};
+    /** Stream queue buffers, generated when the voice starts streaming. */
+    std::array<ALuint, 4> stream_buffers{};
+    bool streaming{false};
+  };
+
+  struct Candidate {
+    unsigned int id;
+    int priority;
+    float audibility;
+  };
+
+  using Clock = std::chrono::steady_clock;
+
   /** Set listener data */
   void listener(const Listener &listener);
 
   /** Update internal stream source representation. */
-  void stream_source(const StreamSource &stream_source);
+  void stream_source(const StreamSource &stream_source, Channel &channel);
 
   /** Update internal buffer source representation. */
-  void buffer_source(const BufferSource &buffer_source);
+  void buffer_source(const BufferSource &buffer_source, Channel &channel);
+
+  /** Find or create the channel of a source and mark it as present. */
+  Channel &channel(const Source &source);
+
+  /** Add a playing source to the voice candidates. */
+  void candidate(const Source &source, const Channel &channel,
+                 const float duration, const Listener &listener);
+
+  /** Set obstruction filter gains, Source::obstructed is already smoothed by Obstruction. */
+  void obstruct(const Source &source, Channel &channel) const;
+
+  /** Take a voice from the pool and apply source properties to it, false if none is free. */
+  bool bind(const Source &source, Channel &channel);
+
+  /** Stop the voice of a channel and return it to the pool. */
+  void release(Channel &channel);
+
+  /** Keep track of the play position of a virtual source. */
+  void advance(const Source &source, Channel &channel, const float duration,
+               const float dt) const;
+
+  /** Gain x distance attenuation x obstruction. */
+  static float audibility(const Source &source, const Listener &listener);
 
   ALCdevice *device_;
   ALCcontext *context_;
@@ -56,14 +123,23 @@ private:
 
   using SourcePair = std::pair<unsigned int, ALuint>;
   using BufferPair = std::pair<unsigned int, ALuint>;
-  using Sources = std::unordered_map<unsigned int, ALuint>;
   using Buffers = std::unordered_map<unsigned int, ALuint>;
   using Filters = std::unordered_map<unsigned int, ALuint>;
 
-  Sources sources_;
+  using Channels = std::unordered_map<unsigned int, Channel>;
+
+  /** All AL sources in the pool. */
+  std::vector<ALuint> voices_;
+  std::vector<ALuint> free_voices_;
+
+  Channels channels_;
   Buffers buffers_;
   Filters filters_;
 
+  std::vector<Candidate> candidates_;
+  Clock::time_point time_;
+  unsigned int frame_{0};
+
 };
 }
 }
\ No newline at end of file
@@ -14,7 +14,8 @@ public:
          const float gain = 1.0f,
          const bool loop = false,
          const bool playing = false,
-         const float obstructed = 0.0f);
+         const float obstructed = 0.0f,
+         const int priority = 0);
   ~Source();
 
   /** Unique id. */
@@ -34,6 +35,8 @@ public:
   bool playing;
   /** How much the source is obstructed. 0.0 - 1.0 */
   float obstructed;
+  /** Sources with higher priority get real voices first. */
+  int priority;
 
 private:
   static std::atomic_uint current_id_;
@@ -36,6 +36,12 @@ public:
   /** Restart streaming. */
   void seek_start();
 
+  /** Continue streaming from a position in seconds. */
+  void seek(float position);
+
+  /** Read position in seconds. */
+  float position() const;
+
   /** Unique id. */
   unsigned int id() const;
 private:
@@ -1,21 +1,24 @@
 #pragma once
 #include <vector>
+#include <memory>
 #include <chrono>
 #include <initializer_list>
 #include <mos/core/tracked_container.hpp>
 
 namespace mos {
 
-template<class T> class TrackedContainer;
+template<class T, class Allocator> class TrackedContainer;
 
 /** Container. */
-template<class T>
+template<class T, class Allocator = std::allocator<T>>
 class Container {
 public:
-  using Items = std::vector<T>;
+  using Items = std::vector<T, Allocator>;
 
   Container() = default;
 
+  explicit Container(const Allocator &allocator) : items_(allocator) {}
+
   template<class It>
   Container(const std::initializer_list<It> list): Container(list.begin(), list.end()){}
 
@@ -24,7 +27,11 @@ public:
     assign(begin, end);
   }
 
-  Container(const TrackedContainer<T> & container) : Container(container.begin(), container.end()){}
+  template<class A>
+  Container(const TrackedContainer<T, A> & container) : Container(container.begin(), container.end()){}
+
+  template<class A>
+  Container(const Container<T, A> & container) : Container(container.begin(), container.end()){}
 
   template<class It>
   void assign(It begin, It end){
@@ -66,15 +73,29 @@ public:
   const T * data() const noexcept {
     return items_.data();
   }
+  T * data() noexcept {
+    return items_.data();
+  }
   void clear() {
     items_.clear();
   }
+  /** Keeps capacity when shrinking. */
+  void resize(typename Items::size_type size) {
+    items_.resize(size);
+  }
+  void reserve(typename Items::size_type capacity) {
+    items_.reserve(capacity);
+  }
+  typename Items::size_type capacity() const {
+    return items_.capacity();
+  }
 
   void push_back(const T &item){
     items_.push_back(item);
   }
 
-  void append(const Container<T> &container) {
+  template<class A>
+  void append(const Container<T, A> &container) {
     insert(end(), container.begin(), container.end());
   }
 
@@ -0,0 +1,100 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <vector>
+#include <mos/core/container.hpp>
+#include <mos/core/tracked_container.hpp>
+
+namespace mos {
+
+/**
+ * Linear allocator for data that lives at most until the end of the next
+ * frame. Allocation bumps an offset, is lock free and safe from any thread,
+ * and nothing is freed on its own. Two buffers take turns, frame() starts
+ * reusing the one from two frames ago. Allocations that do not fit go to
+ * the heap, and the buffer grows to hold them when it is reused, so a
+ * steady workload stops calling the heap after a frame or two.
+ */
+class FrameArena final {
+public:
+  explicit FrameArena(size_t capacity = size_t(1) << 20);
+  FrameArena(const FrameArena &arena) = delete;
+  FrameArena &operator=(const FrameArena &arena) = delete;
+
+  void *allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+  /** Start a new frame, while no other thread allocates. Invalidates memory allocated two frames ago. */
+  void frame();
+
+  /** Bytes allocated this frame. */
+  size_t used() const;
+
+  /** Bytes available this frame before falling back on the heap. */
+  size_t capacity() const;
+
+private:
+  struct Buffer {
+    std::unique_ptr<unsigned char[]> data;
+    size_t capacity = 0;
+    std::atomic_size_t used{0};
+    std::mutex mutex;
+    std::vector<std::unique_ptr<unsigned char[]>> overflow;
+    size_t overflow_size = 0;
+  };
+  std::array<Buffer, 2> buffers_;
+  size_t index_;
+};
+
+/**
+ * Standard library allocator on a FrameArena, deallocation does nothing.
+ * There is no default arena, the owner of the arena calls frame() on it.
+ */
+template<class T>
+class FrameAllocator {
+public:
+  using value_type = T;
+
+  explicit FrameAllocator(FrameArena &arena) noexcept : arena_(&arena) {}
+
+  template<class U>
+  FrameAllocator(const FrameAllocator<U> &other) noexcept : arena_(&other.arena()) {}
+
+  T *allocate(const size_t n) {
+    return static_cast<T *>(arena_->allocate(n * sizeof(T), alignof(T)));
+  }
+
+  void deallocate(T *, size_t) noexcept {}
+
+  FrameArena &arena() const noexcept {
+    return *arena_;
+  }
+
+  template<class U>
+  bool operator==(const FrameAllocator<U> &other) const noexcept {
+    return arena_ == &other.arena();
+  }
+
+  template<class U>
+  bool operator!=(const FrameAllocator<U> &other) const noexcept {
+    return !(*this == other);
+  }
+
+private:
+  FrameArena *arena_;
+};
+
+/** Vector in frame memory. */
+template<class T>
+using FrameVector = std::vector<T, FrameAllocator<T>>;
+
+/** Container in frame memory, for per frame scenes and the like. Construct with a FrameAllocator. */
+template<class T>
+using FrameContainer = Container<T, FrameAllocator<T>>;
+
+template<class T>
+using FrameTrackedContainer = TrackedContainer<T, FrameAllocator<T>>;
+}
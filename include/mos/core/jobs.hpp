@@ -0,0 +1,115 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace mos {
+
+/**
+ * Counts unfinished jobs. Pass the same counter to several Jobs::run calls
+ * and wait on it to join them all, or make other jobs depend on it.
+ */
+class JobCounter final {
+public:
+  JobCounter() = default;
+  JobCounter(const JobCounter &counter) = delete;
+  JobCounter &operator=(const JobCounter &counter) = delete;
+
+  /** True when every counted job has run. */
+  bool done() const;
+
+private:
+  friend class Jobs;
+  std::atomic_size_t count_{0};
+  std::mutex mutex_;
+  /** Jobs to run once the count reaches zero, with the counter each adds to. */
+  std::vector<std::pair<std::function<void()>, JobCounter *>> continuations_;
+  /** First exception thrown by a counted job, rethrown by Jobs::wait. */
+  std::exception_ptr exception_;
+};
+
+/**
+ * Fixed pool of worker threads, one less than the hardware threads, started
+ * on first use. Each worker has its own deque, runs its newest job first
+ * and steals the oldest jobs of others when empty. Jobs from other threads
+ * go to a shared queue. Threads waiting on a counter run jobs meanwhile,
+ * so jobs may run and wait on other jobs.
+ *
+ *   JobCounter counter;
+ *   Jobs::run([&]() { decode(a); }, counter);
+ *   Jobs::run([&]() { decode(b); }, counter);
+ *   Jobs::wait(counter);
+ */
+class Jobs final {
+public:
+  Jobs() = delete;
+
+  /** Number of worker threads, not counting threads that wait. */
+  static size_t workers();
+
+  /** Queue a job, counted by counter until it has run. */
+  static void run(std::function<void()> job, JobCounter &counter);
+
+  /** Queue a job once all jobs counted by dependency have run. */
+  static void run_after(JobCounter &dependency, std::function<void()> job, JobCounter &counter);
+
+  /** Run queued jobs, or sleep when there are none, until every job counted by counter has run. Rethrows the first exception of those jobs. */
+  static void wait(JobCounter &counter);
+
+  /**
+   * Call function(range_begin, range_end) for consecutive ranges of at most
+   * grain indices from begin to end, on the workers and the calling thread.
+   * Returns when all ranges are done.
+   */
+  template<class Function>
+  static void parallel_for(size_t begin, size_t end, size_t grain, const Function &function);
+
+private:
+  struct Task;
+  struct Queue;
+  struct State;
+  static State &state();
+  /** Run a job and count it as done, then queue what depended on its counter. */
+  static void execute(Task &task);
+};
+
+template<class Function>
+void Jobs::parallel_for(const size_t begin, const size_t end, const size_t grain, const Function &function) {
+  const size_t size = std::max<size_t>(grain, 1);
+  if (end <= begin + size) {
+    if (begin < end) {
+      function(begin, end);
+    }
+    return;
+  }
+  // Jobs capture the shared ranges and an index, small enough for std::function to store without allocating.
+  struct Ranges {
+    const Function *function;
+    size_t begin;
+    size_t end;
+    size_t size;
+  };
+  const Ranges ranges{&function, begin, end, size};
+  JobCounter counter;
+  for (size_t index = 1; index < (end - begin + size - 1) / size; index++) {
+    const Ranges *shared = &ranges;
+    run([shared, index]() {
+      const size_t range_begin = shared->begin + index * shared->size;
+      (*shared->function)(range_begin, std::min(range_begin + shared->size, shared->end));
+    }, counter);
+  }
+  // The first range is done here instead of queued.
+  try {
+    function(begin, begin + size);
+  } catch (...) {
+    wait(counter);
+    throw;
+  }
+  wait(counter);
+}
+}
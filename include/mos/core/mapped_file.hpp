@@ -0,0 +1,37 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace mos {
+
+/**
+ * Read only view of a whole file. Memory mapped where the platform
+ * supports it, otherwise read into memory in one go.
+ */
+class MappedFile final {
+public:
+  explicit MappedFile(const std::string &path);
+  MappedFile(const MappedFile &file) = delete;
+  MappedFile &operator=(const MappedFile &file) = delete;
+  ~MappedFile();
+
+  /** Raw file content. */
+  const unsigned char *data() const;
+
+  /** Size in bytes. */
+  size_t size() const;
+
+  const unsigned char *begin() const;
+
+  const unsigned char *end() const;
+
+  /** 64 bit FNV-1a hash of the content. */
+  uint64_t hash() const;
+
+private:
+  const unsigned char *data_;
+  size_t size_;
+  std::vector<unsigned char> fallback_;
+};
+}
@@ -0,0 +1,77 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * CPU instrumentation. Build with MOS_PROFILE to record zones, otherwise the
+ * macros compile to nothing. Zone names must be string literals.
+ *
+ *   MOS_PROFILE_ZONE("Mesh::calculate_normals");
+ *   ...
+ *   MOS_PROFILE_FRAME();
+ */
+#ifdef MOS_PROFILE
+#define MOS_PROFILE_CONCAT_(a, b) a##b
+#define MOS_PROFILE_CONCAT(a, b) MOS_PROFILE_CONCAT_(a, b)
+#define MOS_PROFILE_ZONE(name) \
+  const ::mos::ProfileZone MOS_PROFILE_CONCAT(mos_profile_zone_, __LINE__)("" name)
+#define MOS_PROFILE_FRAME() ::mos::Profiler::frame()
+#else
+#define MOS_PROFILE_ZONE(name) do {} while (false)
+#define MOS_PROFILE_FRAME() do {} while (false)
+#endif
+
+namespace mos {
+
+/** Collects zones recorded on all threads. */
+class Profiler final {
+public:
+  /** Time spent in one zone during a frame, summed over all threads. */
+  struct Summary {
+    const char *name;
+    double milliseconds;
+    unsigned int calls;
+  };
+
+  /** Recorded zone. */
+  struct Event {
+    const char *name;
+    int64_t start;
+    int64_t end;
+    unsigned int thread;
+  };
+
+  Profiler() = delete;
+
+  /** Mark the end of a frame, gathers events from all threads. */
+  static void frame();
+
+  /** Zones of the last completed frame, most expensive first. */
+  static std::vector<Summary> summary();
+
+  /** Number of events kept for write_trace. */
+  static void history(const size_t events);
+
+  /** Write gathered events as Chrome trace event JSON (chrome://tracing). */
+  static void write_trace(const std::string &path);
+
+  /** Nanoseconds on a monotonic clock. */
+  static int64_t now();
+
+  /** Record a finished zone on the calling thread. Lock free. */
+  static void record(const char *name, const int64_t start, const int64_t end);
+};
+
+/** Records the time from construction to destruction. Use MOS_PROFILE_ZONE. */
+class ProfileZone final {
+public:
+  explicit ProfileZone(const char *name) : name_(name), start_(Profiler::now()) {}
+  ProfileZone(const ProfileZone &zone) = delete;
+  ~ProfileZone() { Profiler::record(name_, start_, Profiler::now()); }
+
+private:
+  const char *name_;
+  int64_t start_;
+};
+}
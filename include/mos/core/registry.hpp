@@ -0,0 +1,241 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace mos {
+
+/** Slot in a Registry, with the generation the slot had when handed out. */
+struct Handle {
+  static constexpr uint32_t invalid = std::numeric_limits<uint32_t>::max();
+  uint32_t index = invalid;
+  uint32_t generation = 0;
+  bool valid() const {
+    return index != invalid;
+  }
+};
+
+/**
+ * Values keyed by resource ids, like Mesh::id() or Texture::id(), kept in
+ * dense slots. Ids index pages of handles directly, so a lookup is an
+ * indexed load and a generation compare instead of hashing. Erased slots
+ * are reused with the next generation, which makes handles to them stale.
+ * Pages are freed when their last id is erased, and only the span of pages
+ * between the lowest and highest live ids is kept, so memory follows the
+ * live entries as ids keep growing.
+ */
+template<class T>
+class Registry {
+public:
+  /** Insert unless the id is present, like std::map::insert. */
+  Handle insert(const unsigned int id, T value) {
+    auto *entry = page_entry(id, true);
+    if (entry->valid()) {
+      return *entry;
+    }
+    uint32_t index;
+    if (free_.empty()) {
+      index = uint32_t(slots_.size());
+      slots_.emplace_back();
+    } else {
+      index = free_.back();
+      free_.pop_back();
+    }
+    auto &slot = slots_[index];
+    slot.value = std::move(value);
+    slot.id = id;
+    slot.occupied = true;
+    size_++;
+    *entry = Handle{index, slot.generation};
+    pages_[(id >> page_bits) - first_page_]->count++;
+    return *entry;
+  }
+
+  void insert_or_assign(const unsigned int id, T value) {
+    if (auto *found = find(id)) {
+      *found = std::move(value);
+    } else {
+      insert(id, std::move(value));
+    }
+  }
+
+  /** Handle of an id, invalid if absent. */
+  Handle handle(const unsigned int id) const {
+    const auto *entry = page_entry(id);
+    return entry ? *entry : Handle();
+  }
+
+  /** Value of a handle, nullptr once its slot was erased. */
+  T *get(const Handle handle) {
+    return const_cast<T *>(static_cast<const Registry *>(this)->get(handle));
+  }
+
+  const T *get(const Handle handle) const {
+    if (handle.index >= slots_.size()) {
+      return nullptr;
+    }
+    const auto &slot = slots_[handle.index];
+    return slot.occupied && slot.generation == handle.generation ? &slot.value : nullptr;
+  }
+
+  /** Value of an id, nullptr if absent. */
+  T *find(const unsigned int id) {
+    return get(handle(id));
+  }
+
+  const T *find(const unsigned int id) const {
+    return get(handle(id));
+  }
+
+  T &at(const unsigned int id) {
+    return const_cast<T &>(static_cast<const Registry *>(this)->at(id));
+  }
+
+  const T &at(const unsigned int id) const {
+    const auto *value = find(id);
+    if (!value) {
+      throw std::out_of_range("No registry entry for id " + std::to_string(id) + ".");
+    }
+    return *value;
+  }
+
+  bool contains(const unsigned int id) const {
+    return find(id) != nullptr;
+  }
+
+  /** Destroys the value and frees its slot. */
+  bool erase(const unsigned int id) {
+    auto *entry = page_entry(id);
+    if (!entry || !entry->valid()) {
+      return false;
+    }
+    auto &slot = slots_[entry->index];
+    slot.value = T();
+    slot.occupied = false;
+    slot.generation++;
+    free_.push_back(entry->index);
+    *entry = Handle();
+    size_--;
+    release_page(id >> page_bits);
+    return true;
+  }
+
+  void clear() {
+    for (const auto &slot : slots_) {
+      if (slot.occupied) {
+        erase(slot.id);
+      }
+    }
+  }
+
+  size_t size() const {
+    return size_;
+  }
+
+  /** Bytes of the pages that map ids to slots, and of their table. */
+  size_t index_bytes() const {
+    size_t bytes = pages_.size() * sizeof(pages_[0]);
+    for (const auto &entries : pages_) {
+      bytes += entries ? sizeof(Page) : 0;
+    }
+    return bytes;
+  }
+
+  /** Call function(id, value) for every entry, in slot order. */
+  template<class Function>
+  void for_each(const Function &function) {
+    for (auto &slot : slots_) {
+      if (slot.occupied) {
+        function(slot.id, slot.value);
+      }
+    }
+  }
+
+  template<class Function>
+  void for_each(const Function &function) const {
+    for (const auto &slot : slots_) {
+      if (slot.occupied) {
+        function(slot.id, slot.value);
+      }
+    }
+  }
+
+private:
+  static constexpr unsigned int page_bits = 12;
+  static constexpr unsigned int page_size = 1u << page_bits;
+  struct Page {
+    std::array<Handle, page_size> handles;
+    /** Valid handles. */
+    uint32_t count = 0;
+  };
+
+  struct Slot {
+    T value = T();
+    unsigned int id = 0;
+    uint32_t generation = 0;
+    bool occupied = false;
+  };
+
+  const Handle *page_entry(const unsigned int id) const {
+    const auto page = id >> page_bits;
+    if (page < first_page_ || page - first_page_ >= pages_.size()) {
+      return nullptr;
+    }
+    const auto &entries = pages_[page - first_page_];
+    return entries ? &entries->handles[id & (page_size - 1)] : nullptr;
+  }
+
+  Handle *page_entry(const unsigned int id, const bool create = false) {
+    const auto page = id >> page_bits;
+    if (create) {
+      if (pages_.empty()) {
+        first_page_ = page;
+      } else if (page < first_page_) {
+        std::vector<std::unique_ptr<Page>> pages(first_page_ - page);
+        pages.insert(pages.end(), std::make_move_iterator(pages_.begin()), std::make_move_iterator(pages_.end()));
+        pages_ = std::move(pages);
+        first_page_ = page;
+      }
+      if (page - first_page_ >= pages_.size()) {
+        pages_.resize(page - first_page_ + 1);
+      }
+      auto &entries = pages_[page - first_page_];
+      if (!entries) {
+        entries = std::make_unique<Page>();
+      }
+    }
+    return const_cast<Handle *>(static_cast<const Registry *>(this)->page_entry(id));
+  }
+
+  /** Free a page without entries, and trim empty pages from both ends. */
+  void release_page(const unsigned int page) {
+    auto &entries = pages_[page - first_page_];
+    if (--entries->count > 0) {
+      return;
+    }
+    entries.reset();
+    while (!pages_.empty() && !pages_.back()) {
+      pages_.pop_back();
+    }
+    size_t leading = 0;
+    while (leading < pages_.size() && !pages_[leading]) {
+      leading++;
+    }
+    pages_.erase(pages_.begin(), pages_.begin() + leading);
+    first_page_ = pages_.empty() ? 0 : first_page_ + unsigned(leading);
+  }
+
+  /** Pages from first_page_ on, null where no id is live. */
+  std::vector<std::unique_ptr<Page>> pages_;
+  unsigned int first_page_ = 0;
+  std::vector<Slot> slots_;
+  std::vector<uint32_t> free_;
+  size_t size_ = 0;
+};
+}
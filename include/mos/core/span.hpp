@@ -0,0 +1,45 @@
+#pragma once
+#include <cstddef>
+#include <type_traits>
+
+namespace mos {
+
+/** Non-owning view of contiguous elements, like a Container, std::vector or std::array. */
+template<class T>
+class Span {
+public:
+  using value_type = std::remove_cv_t<T>;
+  using iterator = T *;
+
+  Span() noexcept : data_(nullptr), size_(0) {}
+
+  Span(T *data, const size_t size) noexcept : data_(data), size_(size) {}
+
+  template<class C, class = std::enable_if_t<
+      std::is_convertible<decltype(std::declval<C &>().data()), T *>::value>>
+  Span(C &container) noexcept : Span(container.data(), container.size()) {}
+
+  T *begin() const noexcept {
+    return data_;
+  }
+  T *end() const noexcept {
+    return data_ + size_;
+  }
+  T *data() const noexcept {
+    return data_;
+  }
+  T &operator[](const size_t pos) const {
+    return data_[pos];
+  }
+  size_t size() const noexcept {
+    return size_;
+  }
+  bool empty() const noexcept {
+    return size_ == 0;
+  }
+
+private:
+  T *data_;
+  size_t size_;
+};
+}
@@ -1,24 +1,29 @@
 #pragma once
 #include <vector>
+#include <memory>
 #include <chrono>
 #include <initializer_list>
 #include <mos/core/container.hpp>
 
 namespace mos {
 
-template<class T> class Container;
+template<class T, class Allocator> class Container;
 
 /** Container with modified time stamp. */
-template<class T>
+template<class T, class Allocator = std::allocator<T>>
 class TrackedContainer {
 public:
-  using Items = std::vector<T>;
+  using Items = std::vector<T, Allocator>;
   using TimePoint = std::chrono::time_point<std::chrono::system_clock, std::chrono::nanoseconds>;
 
   TrackedContainer(){
     invalidate();
   };
 
+  explicit TrackedContainer(const Allocator &allocator) : items_(allocator) {
+    invalidate();
+  }
+
   template<class It>
   TrackedContainer(const std::initializer_list<It> list): TrackedContainer(list.begin(), list.end()){}
 
@@ -27,7 +32,8 @@ public:
     assign(begin, end);
   }
 
-  TrackedContainer(const Container<T> &container): TrackedContainer(container.begin(), container.end()){}
+  template<class A>
+  TrackedContainer(const Container<T, A> &container): TrackedContainer(container.begin(), container.end()){}
 
   template<class It>
   void assign(It begin, It end){
@@ -64,10 +70,26 @@ public:
   const T * data() const noexcept {
     return items_.data();
   }
+  /** Counts as a modification, write through it in one go. */
+  T * data() noexcept {
+    invalidate();
+    return items_.data();
+  }
   void clear(){
     items_.clear();
     invalidate();
   }
+  /** Keeps capacity when shrinking. */
+  void resize(typename Items::size_type size){
+    items_.resize(size);
+    invalidate();
+  }
+  void reserve(typename Items::size_type capacity){
+    items_.reserve(capacity);
+  }
+  typename Items::size_type capacity() const {
+    return items_.capacity();
+  }
   void push_back(const T &item){
     items_.push_back(item);
     invalidate();
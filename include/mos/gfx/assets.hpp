@@ -33,7 +33,10 @@ public:
   /** Loads a Mesh from a *.mesh file and caches it internally. */
   SharedMesh mesh(const std::string &path);
 
-  /** Loads Texture2D from a *.png file and caches it internally. */
+  /**
+   * Loads Texture2D from a *.png or *.texture file and caches it internally.
+   * A *.texture file next to a requested *.png is used instead.
+   */
   SharedTexture2D
   texture(const std::string &path,
           bool color_data = true,
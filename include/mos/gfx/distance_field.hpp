@@ -0,0 +1,17 @@
+#pragma once
+
+#include <mos/gfx/font.hpp>
+
+namespace mos {
+namespace gfx {
+
+/**
+ * Font with a signed distance field atlas, generated in parallel per glyph
+ * from the glyph coverage of a bitmap font. The atlas is downscale times
+ * smaller in each dimension and keeps the glyph layout, so one small atlas
+ * replaces bitmap atlases of several sizes. Use a large source atlas.
+ * @param spread Distance in source texels covered by the stored range.
+ */
+Font distance_field_font(const Font &font, int downscale = 4, float spread = 8.0f);
+}
+}
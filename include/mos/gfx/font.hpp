@@ -1,16 +1,35 @@
 #pragma once
 #include <map>
+#include <array>
 #include <memory>
+#include <glm/glm.hpp>
 #include <mos/gfx/character.hpp>
 #include <mos/gfx/texture_2d.hpp>
 
 namespace mos {
 namespace gfx {
 
+class Font;
+using SharedFont = std::shared_ptr<Font>;
+
 /** Bitmap font. */
 class Font final {
 public:
   using CharMap = std::map<char, Character>;
+
+  /** Quad of a character relative to the pen, in units of font height. */
+  struct Glyph {
+    glm::vec2 offset = glm::vec2(0.0f);
+    glm::vec2 size = glm::vec2(0.0f);
+    float advance = 0.0f;
+    /** Normalized texture rectangle. */
+    glm::vec2 uv_min = glm::vec2(0.0f);
+    glm::vec2 uv_max = glm::vec2(0.0f);
+    bool valid = false;
+  };
+  /** Indexed by the byte value of the character. */
+  using Glyphs = std::array<Glyph, 256>;
+
   /** @param characters Chars supported.
    * @param texture Image with glyphs. */
   Font(const CharMap &characters,
@@ -28,15 +47,27 @@ public:
   /** Base line. */
   float base() const;
 
+  /** Layout of a character, invalid if the font does not have it. */
+  const Glyph &glyph(char character) const;
+
   /** Texture with characters. */
   SharedTexture2D texture;
 
   /** Characters supported. */
   CharMap characters;
 
+  /**
+   * The atlas holds signed distances in the red channel, 0.5 at glyph edges.
+   * Such fonts are drawn crisp at any scale by scene texts.
+   */
+  bool distance_field = false;
+
 private:
+  /** Precompute the glyph table from characters and the texture size. */
+  void build_glyphs();
   float base_;
   float height_;
+  Glyphs glyphs_;
 };
 }
 }
@@ -0,0 +1,92 @@
+#pragma once
+#include <glad/glad.h>
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+
+namespace mos {
+namespace gfx {
+
+/** GPU time and work of one render pass. */
+struct PassTiming {
+  std::string name;
+  /** Start, in GPU clock nanoseconds. */
+  GLuint64 start;
+  double milliseconds;
+  unsigned int draws;
+  unsigned int triangles;
+};
+
+/**
+ * Measures render passes with timestamp queries. Queries are kept in a ring
+ * of frames, results are read back when a frame slot comes around again, so
+ * reading never stalls the pipeline.
+ */
+class GpuProfiler final {
+public:
+  using Passes = std::vector<PassTiming>;
+
+  GpuProfiler();
+  GpuProfiler(const GpuProfiler &profiler) = delete;
+  ~GpuProfiler();
+
+  /** Collect finished results and start recording a new frame. */
+  void begin_frame();
+
+  /** Start a named pass, ending any pass still open. */
+  void begin(const char *name);
+
+  /** End the current pass. */
+  void end();
+
+  /** Count a draw call in the current pass. */
+  void draw(const unsigned int triangles = 0);
+
+  /** Most recently resolved frame. */
+  const Passes &passes() const;
+
+  /** Total GPU time of the most recently resolved frame. */
+  double frame_milliseconds() const;
+
+  /** Number of frames resolved so far, changes when passes() does. */
+  uint64_t resolved_frames() const;
+
+  /** Write resolved frames as Chrome trace event JSON (chrome://tracing). */
+  void write_trace(const std::string &path) const;
+
+  /** Measure passes. */
+  bool enabled;
+
+  /** Number of resolved frames kept for write_trace, 0 disables. */
+  size_t trace_frames;
+
+private:
+  struct Query {
+    const char *name;
+    GLuint begin;
+    GLuint end;
+    unsigned int draws;
+    unsigned int triangles;
+  };
+
+  struct Frame {
+    std::vector<GLuint> pool;
+    std::vector<Query> queries;
+  };
+
+  /** Index of a free begin/end query pair in the frame pool. */
+  size_t query(Frame &frame);
+  void resolve(Frame &frame);
+
+  static constexpr size_t frames_in_flight = 4;
+  std::array<Frame, frames_in_flight> frames_;
+  size_t frame_;
+  bool open_;
+  uint64_t resolved_frames_;
+  Passes passes_;
+  std::deque<Passes> history_;
+};
+}
+}
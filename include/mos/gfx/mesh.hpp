@@ -7,6 +7,7 @@
 #include <memory>
 #include <chrono>
 #include <mos/gfx/vertex.hpp>
+#include <mos/gfx/vertex_layout.hpp>
 #include <mos/gfx/shape.hpp>
 #include <mos/core/tracked_container.hpp>
 
@@ -62,6 +63,9 @@ public:
 
   TrackedContainer<Vertex> vertices;
   TrackedContainer<Triangle> triangles;
+
+  /** Format of the vertices in GPU memory, set before the mesh is loaded. */
+  VertexLayout layout;
 private:
   void calculate_tangents(Vertex &v0, Vertex &v1, Vertex &v2);
 
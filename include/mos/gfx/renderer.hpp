@@ -2,9 +2,17 @@
 #include <glad/glad.h>
 #include <optional>
 #include <initializer_list>
-#include <unordered_map>
 #include <array>
-#include <future>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <exception>
+#include <unordered_set>
+#include <limits>
 #include <mos/gfx/scene.hpp>
 #include <mos/gfx/texture_2d.hpp>
 #include <mos/gfx/model.hpp>
@@ -12,12 +20,17 @@
 #include <mos/gfx/particle_cloud.hpp>
 #include <mos/gfx/light.hpp>
 #include <mos/gfx/target.hpp>
+#include <mos/gfx/texture_target.hpp>
 #include <mos/gfx/camera.hpp>
 #include <mos/gfx/environment_light.hpp>
 #include <mos/gfx/fog.hpp>
 #include <mos/gfx/box.hpp>
 #include <mos/gfx/scenes.hpp>
+#include <mos/gfx/scene_view.hpp>
 #include <mos/gfx/lights.hpp>
+#include <mos/gfx/gpu_profiler.hpp>
+#include <mos/core/frame_allocator.hpp>
+#include <mos/core/registry.hpp>
 
 namespace mos {
 namespace gfx {
@@ -55,11 +68,120 @@ public:
   /** Unloads a shared texture from renderer memory. */
   void unload(const SharedTexture2D &texture);
 
+  /**
+   * Upload shared meshes and textures on a worker thread instead of while
+   * rendering. make_current(true) is called once on the worker, and should
+   * make a context current that shares objects with the render context, like
+   * io::Window::shared_context(). make_current(false) releases it before the
+   * worker exits. A model is not drawn until its mesh is resident, textures
+   * still in flight sample a placeholder. Data must not change while its
+   * upload is pending. Errors on the worker are thrown from render calls,
+   * and later loads are uploaded while rendering.
+   */
+  void upload_async(const std::function<void(bool)> &make_current);
+
   /** Render multiple scenes. */
   void render(const Scenes &scenes,
               const glm::vec4 &color = {.0f, .0f, .0f, 1.0f},
               const glm::ivec2 &resolution = glm::ivec2(128, 128));
 
+  /** Render views of scenes stored elsewhere, nothing they reference is copied. */
+  void render(SceneViews scenes,
+              const glm::vec4 &color = {.0f, .0f, .0f, 1.0f},
+              const glm::ivec2 &resolution = glm::ivec2(128, 128));
+
+  /** Render multiple scenes to an offscreen target and queue an asynchronous readback. */
+  void render_offscreen(const Scenes &scenes,
+                        const glm::vec4 &color = {.0f, .0f, .0f, 1.0f},
+                        const glm::ivec2 &resolution = glm::ivec2(128, 128));
+
+  void render_offscreen(SceneViews scenes,
+                        const glm::vec4 &color = {.0f, .0f, .0f, 1.0f},
+                        const glm::ivec2 &resolution = glm::ivec2(128, 128));
+
+  /**
+   * Pixels of the oldest pending offscreen frame, as tightly packed sRGB
+   * RGBA8, bottom row first. Empty if the readback is not done yet, unless
+   * wait is set.
+   */
+  std::optional<std::vector<unsigned char>> read_pixels(const bool wait = false);
+
+  /** How much bloom is added to the final image. */
+  float bloom_strength;
+
+  /** Spread of the bloom upsample filter, in texels of each level. */
+  float bloom_radius;
+
+  /**
+   * Render the scene to a part of the internal targets when the GPU is slow,
+   * then upscale to the output resolution. Nothing is reallocated. GPU time
+   * comes from gpu_profiler(), the scale stays 1.0 while it is disabled.
+   */
+  struct DynamicResolution {
+    bool enabled = false;
+    /** GPU frame time to aim for, in milliseconds. */
+    float target_milliseconds = 16.0f;
+    /** Lowest allowed render scale. */
+    float min_scale = 0.5f;
+    /** Sharpening while upscaling, 0.0 is plain bilinear. */
+    float sharpness = 0.25f;
+  };
+
+  DynamicResolution dynamic_resolution;
+
+  /** Current render scale, 1.0 is the output resolution. */
+  float resolution_scale() const;
+
+  /**
+   * Stream levels of textures with stored mip levels. The smallest levels
+   * are resident from the start, more detailed levels follow their size on
+   * screen, within an upload and a memory budget.
+   */
+  struct TextureStreaming {
+    bool enabled = false;
+    /** Texture memory to stay within, in bytes. */
+    size_t budget = size_t(1) << 30;
+    /** Bytes uploaded per frame, at most one level over. */
+    size_t upload_budget = size_t(16) << 20;
+    /** Levels up to this size are resident when a texture is loaded. */
+    int initial_size = 64;
+    /** Frames without use before a texture is only asked for at its smallest levels. */
+    uint64_t unused_frames = 120;
+  };
+
+  TextureStreaming texture_streaming;
+
+  /** Bytes of resident texture levels. */
+  size_t texture_memory() const;
+
+  /**
+   * Release meshes and textures once the shared data they were loaded from
+   * is gone, and those not rendered for a while. A released resource is
+   * loaded again the next time it is rendered.
+   */
+  struct Residency {
+    /** Frames without use before a mesh or texture is released, 0 keeps them. */
+    uint64_t unused_frames = 0;
+    /** Mesh and texture memory to stay within, in bytes. Least recently used go first, never those of the last frame. */
+    size_t budget = std::numeric_limits<size_t>::max();
+  };
+
+  Residency residency;
+
+  /** Bytes of GPU memory held for loaded resources. */
+  struct Memory {
+    size_t textures = 0;
+    size_t vertex_buffers = 0;
+    size_t index_buffers = 0;
+    size_t total() const;
+  };
+
+  Memory memory() const;
+
+  /** Per pass GPU timings, draw and triangle counts, a few frames old. */
+  GpuProfiler &gpu_profiler();
+  const GpuProfiler &gpu_profiler() const;
+
   /** Clear all internal buffers/memory. */
   void clear_buffers();
 
@@ -69,11 +191,25 @@ private:
   struct Buffer {
     GLuint id;
     TimePoint modified;
+    size_t bytes;
+  };
+
+  /** Last frame a mesh or texture was rendered, and the shared data it was loaded from. */
+  struct Usage {
+    uint64_t frame = 0;
+    std::weak_ptr<const void> owner;
+    /** Loaded from shared data, released when owner expires. */
+    bool shared = false;
+    /** Never released automatically, like the textures of texture targets. */
+    bool pinned = false;
   };
 
   class TextureBuffer2D {
   public:
-    explicit TextureBuffer2D(const Texture2D &texture_2d);
+    /** Uploads levels from base_level and down. */
+    explicit TextureBuffer2D(const Texture2D &texture_2d, int base_level = 0);
+    /** Takes ownership of a texture already uploaded from base_level and down. */
+    TextureBuffer2D(const Texture2D &texture_2d, GLuint texture, int base_level);
     TextureBuffer2D(GLuint internal_format,
                     GLuint external_format,
                     int width,
@@ -83,8 +219,31 @@ private:
                     bool mipmaps,
                     const TimePoint &modified = std::chrono::system_clock::now());
     ~TextureBuffer2D();
+    /** Upload the level above the base level. */
+    void stream_in(const Texture2D &texture_2d);
+    /** Release the base level. */
+    void stream_out();
+    size_t level_size(int level) const;
+    /** Bytes of the levels from the base level and down. */
+    size_t resident_size(bool mipmaps) const;
+    /** Remember the most detailed level wanted since the last streaming pass. */
+    void request(int level);
     GLuint texture;
     TimePoint modified;
+    /** Data to stream more levels from, empty when not streamed. */
+    std::weak_ptr<Texture2D> source;
+    Texture::Format format;
+    int width;
+    int height;
+    int levels;
+    /** Most detailed resident level. */
+    int base_level;
+    int wanted_level;
+    /** Requested since the last streaming pass. */
+    bool requested;
+    /** Bytes of the resident levels. */
+    size_t bytes;
+    Usage usage;
   };
 
   class Shader {
@@ -118,10 +277,18 @@ private:
     GLint mvp;
   };
 
+  struct TextProgram : public Program {
+    TextProgram();
+    GLint view_projection;
+    GLint atlas;
+    GLint distance_field;
+  };
+
   struct MultisampleProgram : public Program {
     MultisampleProgram();
     GLint color_texture;
     GLint depth_texture;
+    GLint uv_scale;
   };
 
   struct BloomProgram : public Program {
@@ -129,17 +296,48 @@ private:
     GLint color_texture;
     GLint bright_color_texture;
     GLint strength;
+    GLint uv_scale;
+    GLint sharpness;
+  };
+
+  struct BloomDownsampleProgram : public Program {
+    BloomDownsampleProgram();
+    GLint color_texture;
+    GLint uv_scale;
   };
 
-  struct BlurProgram : public Program {
-    BlurProgram();
+  struct BloomUpsampleProgram : public Program {
+    BloomUpsampleProgram();
     GLint color_texture;
-    GLint horizontal;
+    GLint radius;
+    GLint uv_scale;
   };
 
   struct DepthProgram : public Program {
     DepthProgram();
     GLint model_view_projection_matrix;
+    GLint position_offset;
+    GLint position_scale;
+  };
+
+  /** Compute program that builds one level of the depth pyramid. */
+  struct DepthPyramidProgram : public Program {
+    DepthPyramidProgram();
+    GLint depth_texture;
+    GLint samples;
+    GLint level;
+    GLint source_resolution;
+  };
+
+  /** Compute program that tests draw bounds against the depth pyramid. */
+  struct OcclusionCullProgram : public Program {
+    OcclusionCullProgram();
+    GLint depth_pyramid;
+    GLint view_projection;
+    GLint resolution;
+    GLint levels;
+    GLint draw_count;
+    GLint phase;
   };
 
 
@@ -160,6 +358,9 @@ private:
     GLint model_matrix;
     GLint normal_matrix;
     std::array<GLint,2> depth_bias_mvps;
+    GLint position_offset;
+    GLint position_scale;
+    GLint octahedral;
 
     struct EnvironmentUniforms {
       GLint map;
@@ -210,6 +411,9 @@ private:
     GLint model_matrix;
     GLint normal_matrix;
     std::array<GLint,2> depth_bias_mvps;
+    GLint position_offset;
+    GLint position_scale;
+    GLint octahedral;
 
     struct EnvironmentUniforms {
       GLint map;
@@ -257,48 +461,287 @@ private:
     GLint brdf_lut;
   };
 
-  void render_texture_targets(const Scene &scene);
+  void render_frame(SceneViews scenes,
+                    const glm::vec4 &color,
+                    const glm::ivec2 &resolution,
+                    GLuint frame_buffer);
+
+  /** Adjust the render scale from measured GPU frame time. */
+  void update_resolution_scale();
+
+  /** A model with matrices computed once per frame. */
+  struct Node {
+    const Model *model = nullptr;
+    /** Index of the parent node, npos for top level models. */
+    size_t parent = npos;
+    glm::mat4 local = glm::mat4(1.0f);
+    glm::mat4 world = glm::mat4(1.0f);
+    glm::mat3 normal = glm::mat3(1.0f);
+    /** Matrices were recomputed this frame. */
+    bool dirty = true;
+  };
+
+  static constexpr size_t npos = std::numeric_limits<size_t>::max();
+
+  /**
+   * Models of a scene flattened in draw order, parents before children, and
+   * read by every pass. Matrices are kept for nodes whose transform and
+   * ancestors did not change since the last frame.
+   */
+  struct SceneNodes {
+    /** Nodes from which matrices are computed on several threads. */
+    static constexpr size_t parallel_nodes = 4096;
+    void update(Span<const Model> models);
+    std::vector<Node> nodes;
+    /** First node of each top level model, and the node count last. */
+    std::vector<size_t> roots;
+  private:
+    /** First root of each job's run of top level models, and the root count last. */
+    std::vector<size_t> chunks_;
+    void add(const Model &model, size_t parent, size_t previous, size_t &count);
+  };
+
+  /** Create the frame buffer and texture of a target the first time it is seen. */
+  void load(const TextureTarget &target);
+
+  /** Ask for texture levels from the size of a model on screen. */
+  void request_texture_levels(const Model &model,
+                              const glm::mat4 &transform,
+                              const Camera &camera,
+                              const glm::vec2 &resolution);
+
+  /** Upload wanted levels and evict the least recently used ones. */
+  void stream_textures();
+
+  /** Evict levels until needed bytes fit within the budget, never from keep. */
+  bool evict_textures(size_t needed, size_t &memory, const TextureBuffer2D *keep);
+
+  /** Most detailed level resident when a streamed texture is loaded. */
+  int initial_level(const Texture2D &texture) const;
+
+  /** Mark a mesh or particle cloud as used this frame. */
+  Usage &use_buffers(unsigned int id);
+
+  /** Delete the vertex array and buffers of a mesh or particle cloud. */
+  void unload_buffers(unsigned int id);
+
+  /** Release what residency asks for, after a frame is rendered. */
+  void release_unused();
+
+  /** A mesh or texture copied to GL objects on the upload thread. */
+  struct Upload {
+    /** Delete the GL objects. */
+    void release();
+    SharedMesh mesh;
+    SharedTexture2D texture;
+    /** Of the vertices or texture data when queued. */
+    TimePoint modified;
+    TimePoint triangles_modified;
+    int base_level = 0;
+    bool streamed = false;
+    VertexLayout layout;
+    GLuint array_buffer = 0;
+    GLuint element_array_buffer = 0;
+    GLuint texture_buffer = 0;
+    GLsync fence = nullptr;
+  };
+
+  /**
+   * Worker thread with its own shared context. Data is copied into mapped
+   * buffers and pixel unpack buffers there, and a fence follows each upload.
+   */
+  class UploadQueue {
+  public:
+    explicit UploadQueue(const std::function<void(bool)> &make_current);
+    ~UploadQueue();
+    void push(Upload upload);
+    /** Uploads whose fence has signaled, in the order they were pushed. Rethrows a worker error. */
+    std::vector<Upload> poll();
+  private:
+    void run(const std::function<void(bool)> make_current);
+    /** Upload until stopped. */
+    void process();
+    std::mutex mutex_;
+    std::condition_variable condition_;
+    std::deque<Upload> queued_;
+    std::deque<Upload> done_;
+    bool stop_;
+    /** Thrown on the worker, which has exited. */
+    std::exception_ptr error_;
+    std::thread thread_;
+  };
+
+  /** Swap in finished uploads. */
+  void finish_uploads();
+
+  /** True when the mesh can be drawn. */
+  bool resident(const SharedMesh &mesh) const;
+
+  /** GL texture of a resident texture, otherwise the placeholder. */
+  GLuint texture_or(const SharedTexture2D &texture, const TextureBuffer2D &placeholder) const;
+
+  /** Samples passed in the opaque pass, to decide on a depth pre-pass. */
+  struct Overdraw {
+    Overdraw();
+    ~Overdraw();
+    void begin();
+    void end(const glm::ivec2 &resolution, const int samples_per_pixel);
+    std::array<GLuint, 2> queries;
+    std::array<float, 2> samples;
+    std::array<bool, 2> pending;
+    size_t index;
+    /** Average number of times each sample was rasterized. */
+    float value;
+    bool prepass;
+  };
+
+  /**
+   * Occlusion culling of one scene. Every mesh drawn gets an indirect
+   * command whose instance count is set by the cull shader. The first phase
+   * tests against last frame's depth pyramid, the second phase rebuilds the
+   * pyramid and draws what the first phase missed.
+   */
+  struct Occlusion {
+    /** Phases drawn by the next traversal. */
+    enum class Phase {
+      FIRST, SECOND, BOTH
+    };
+    struct Bounds {
+      glm::vec4 min;
+      glm::vec4 max;
+    };
+    struct Command {
+      GLuint count;
+      GLuint instance_count;
+      GLuint first_index;
+      GLuint base_vertex;
+      GLuint base_instance;
+    };
+    explicit Occlusion(const glm::ivec2 &resolution);
+    ~Occlusion();
+    /** Draw the next mesh in traversal order. */
+    void draw_elements();
+    std::vector<Bounds> bounds;
+    std::vector<Command> commands;
+    GLuint bounds_buffer;
+    GLuint command_buffer;
+    GLuint visible_buffer;
+    GLuint depth_pyramid;
+    /** Part of the pyramid built last, zero before the first build. */
+    glm::ivec2 pyramid_resolution;
+    int pyramid_levels;
+    int pyramid_levels_allocated;
+    size_t next;
+    Phase phase;
+  };
+
+  /** What a pass reads from its draw commands. */
+  enum class Pass {
+    DEPTH, ENVIRONMENT, STANDARD
+  };
+
+  /**
+   * A model draw with matrices and material inputs worked out, built on a
+   * worker thread and replayed as is on the GL thread.
+   */
+  struct DrawCommand {
+    const Node *node = nullptr;
+    /** Zero when the mesh is not resident, then nothing is drawn. */
+    GLuint vertex_array = 0;
+    GLsizei count = 0;
+    /** Translucent anywhere, by opacity or map alpha. Left out of the depth pre-pass and occlusion. */
+    bool transparent = false;
+    glm::mat4 model_view_projection;
+    /** Decode quantized positions and octahedral normals of the vertex layout. */
+    glm::vec3 position_offset;
+    glm::vec3 position_scale;
+    bool octahedral = false;
+    std::array<glm::mat4, 2> depth_bias_mvps;
+    glm::vec4 albedo;
+    glm::vec4 emission;
+    /** Albedo, emission, normal, metallic, roughness and ambient occlusion maps. */
+    std::array<GLuint, 6> textures;
+    /** World space, for occlusion culling. */
+    Occlusion::Bounds bounds;
+  };
+
+  /** Commands of one pass, one per node and in node order. */
+  using DrawCommands = std::vector<DrawCommand>;
+
+  /** Commands of every pass in a frame, kept to reuse their storage. */
+  struct FrameCommands {
+    std::array<DrawCommands, 2> shadow_maps;
+    std::array<DrawCommands, 2> environment_maps;
+    std::vector<DrawCommands> texture_targets;
+    std::vector<DrawCommands> scenes;
+  };
+
+  /** Nodes per command building task. */
+  static constexpr size_t command_chunk = 512;
+
+  /**
+   * Build commands for nodes from begin to end. Only reads renderer state,
+   * so chunks of several passes are built on worker threads at once.
+   */
+  void build_commands(const SceneNodes &nodes,
+                      size_t begin,
+                      size_t end,
+                      const glm::mat4 &view_projection,
+                      const Lights &lights,
+                      Pass pass,
+                      DrawCommands &commands) const;
+
+  /** Build the commands of all passes of the frame in parallel. */
+  void build_frame_commands(SceneViews scenes);
+
+  void render_texture_targets(const SceneView &scene, const std::vector<DrawCommands> &commands);
 
   void render_scene(const Camera &camera,
-                    const Scene &scene,
-                    const glm::ivec2 &resolution);
+                    const SceneView &scene,
+                    const DrawCommands &commands,
+                    const glm::ivec2 &resolution,
+                    Overdraw *overdraw = nullptr,
+                    Occlusion *occlusion = nullptr);
+
+  /** Collect world bounds and indirect commands in the order models are drawn. */
+  void gather_draws(const DrawCommands &commands, Occlusion &occlusion) const;
+
+  void cull(Occlusion &occlusion, const Camera &camera, const int phase);
+
+  /** Farthest depth pyramid of the current depth buffer. */
+  void build_depth_pyramid(Occlusion &occlusion, const glm::ivec2 &resolution);
 
-  void render_shadow_maps(const Models &models,
+  void render_shadow_maps(const std::array<DrawCommands, 2> &commands,
                           const Lights &lights);
 
-  void render_environment(const Scene &scene,
+  void render_environment(const SceneView &scene,
+                          const std::array<DrawCommands, 2> &commands,
                           const glm::vec4 &clear_color);
 
-  void render_boxes(const Boxes & boxes,
+  void render_boxes(Span<const gfx::Box> boxes,
                     const mos::gfx::Camera &camera);
 
-  void render_particles(const ParticleClouds &clouds,
+  /** Draw texts with one call per font atlas. */
+  void render_texts(Span<const Text> texts, const Camera &camera);
+
+  void render_particles(Span<const ParticleCloud> clouds,
                         const mos::gfx::Camera &camera,
                         const glm::vec2 &resolution);
 
-  void render_model(const Model &model,
-                    const glm::mat4 &transform,
+  void render_model(const DrawCommand &command,
                     const Camera &camera,
-                    const Lights &lights,
-                    const EnvironmentLights &environment_lights,
-                    const Fog &fog,
                     const glm::vec2 &resolution,
-                    const StandardProgram& program);
+                    const StandardProgram& program,
+                    const bool depth_prepass = false,
+                    Occlusion *occlusion = nullptr);
 
-  void render_model(const Model &model,
-                    const glm::mat4 &transform,
-                    const Camera &camera,
-                    const Lights &lights,
-                    const EnvironmentLights &environment_lights,
-                    const Fog &fog,
-                    const glm::vec2 &resolution,
+  void render_model(const DrawCommand &command,
                     const EnvironmentProgram& program);
 
-  void render_model_depth(const Model &model,
-                          const glm::mat4 &transform,
-                          const Camera &camera,
-                          const glm::vec2 &resolution,
-                          const DepthProgram& program);
+  void render_model_depth(const DrawCommand &command,
+                          const DepthProgram& program,
+                          const bool opaque_only = false,
+                          Occlusion *occlusion = nullptr);
 
   /** Clear color and depth. */
   void clear(const glm::vec4 &color);
@@ -310,24 +753,67 @@ private:
   const EnvironmentProgram environment_program_;
   const ParticleProgram particle_program_;
   const BoxProgram box_program_;
+  const TextProgram text_program_;
   const DepthProgram depth_program_;
   const MultisampleProgram multisample_program_;
   const BloomProgram bloom_program_;
-  const BlurProgram blur_program_;
+  const BloomDownsampleProgram bloom_downsample_program_;
+  const BloomUpsampleProgram bloom_upsample_program_;
+  const DepthPyramidProgram depth_pyramid_program_;
+  const OcclusionCullProgram occlusion_cull_program_;
+
+  GpuProfiler gpu_profiler_;
+
+  float resolution_scale_;
+
+  /** Profiler frame the resolution scale was last updated from. */
+  uint64_t resolution_sample_;
 
-  std::unordered_map<unsigned int, GLuint> frame_buffers_;
-  std::unordered_map<unsigned int, GLuint> render_buffers;
-  std::unordered_map<unsigned int, std::unique_ptr<TextureBuffer2D>> textures_;
-  std::unordered_map<unsigned int, Buffer> array_buffers_;
-  std::unordered_map<unsigned int, Buffer> element_array_buffers_;
-  std::unordered_map<unsigned int, GLuint> vertex_arrays_;
+  uint64_t frame_;
+
+  /** Transient data of the current and previous frame. */
+  FrameArena frame_arena_;
+
+  /** Per index in the rendered scenes. */
+  std::vector<std::unique_ptr<Overdraw>> overdraws_;
+  std::vector<std::unique_ptr<Occlusion>> occlusions_;
+  std::vector<SceneNodes> scene_nodes_;
+  FrameCommands commands_;
+
+  /** Object space bounds of loaded meshes. */
+  struct MeshBounds {
+    MeshBounds() = default;
+    explicit MeshBounds(const Mesh &mesh);
+    glm::vec3 min;
+    glm::vec3 max;
+  };
+  Registry<MeshBounds> mesh_bounds_;
+  /** Of the array buffer of each loaded mesh. */
+  Registry<VertexLayout> vertex_layouts_;
+
+  /** GL objects by the id of the mesh, particle cloud, texture or target they belong to. */
+  Registry<GLuint> frame_buffers_;
+  Registry<GLuint> render_buffers;
+  Registry<std::unique_ptr<TextureBuffer2D>> textures_;
+  Registry<Buffer> array_buffers_;
+  Registry<Buffer> element_array_buffers_;
+  Registry<GLuint> vertex_arrays_;
+  /** By mesh or particle cloud id. */
+  Registry<Usage> buffer_usage_;
+
+  std::unique_ptr<UploadQueue> upload_queue_;
+  /** Ids with an upload in flight, an id missing when it finishes was unloaded. */
+  std::unordered_set<unsigned int> pending_meshes_;
+  std::unordered_set<unsigned int> pending_textures_;
 
   struct StandardTarget {
+    static constexpr GLsizei samples = 4;
     StandardTarget(const glm::ivec2 &resolution);
     ~StandardTarget();
     GLuint frame_buffer;
     GLuint texture;
     GLuint depth_texture;
+    glm::ivec2 resolution;
   };
 
   const StandardTarget standard_target_;
@@ -342,15 +828,30 @@ private:
 
   const MultiTarget multi_target_;
 
-  struct BlurTarget {
-    BlurTarget(const glm::ivec2 &resolution);
-    ~BlurTarget();
+  /** Final image and double buffered readback, for rendering without a window. */
+  struct OffscreenTarget {
+    explicit OffscreenTarget(const glm::ivec2 &resolution);
+    ~OffscreenTarget();
     GLuint frame_buffer;
     GLuint texture;
+    std::array<GLuint, 2> pixel_buffers;
+    std::array<GLsync, 2> fences;
+    size_t index;
+    glm::ivec2 resolution;
+  };
+
+  std::unique_ptr<OffscreenTarget> offscreen_target_;
+
+  /** Bloom mip chain, each level half the size of the previous, starting at half resolution. */
+  struct BloomTarget {
+    explicit BloomTarget(const glm::ivec2 &resolution);
+    ~BloomTarget();
+    GLuint frame_buffer;
+    std::vector<GLuint> textures;
+    std::vector<glm::ivec2> resolutions;
   };
 
-  const BlurTarget blur_target0_;
-  const BlurTarget blur_target1_;
+  const BloomTarget bloom_target_;
 
   struct Quad {
     Quad();
@@ -371,6 +872,34 @@ private:
 
   const Box box;
 
+  /** Glyph quads of all texts, in world space, rebuilt every draw. */
+  struct TextBatch {
+    struct GlyphVertex {
+      glm::vec3 position;
+      glm::vec2 uv;
+      glm::vec4 color;
+    };
+    /** Quads sampling one atlas. */
+    struct Range {
+      SharedTexture2D atlas;
+      bool distance_field;
+      size_t first;
+      size_t count;
+    };
+    TextBatch();
+    ~TextBatch();
+    /** Grow the index buffer to hold at least quads. */
+    void reserve(size_t quads);
+    GLuint vertex_array;
+    GLuint buffer;
+    GLuint element_buffer;
+    size_t capacity;
+    std::vector<GlyphVertex> vertices;
+    std::vector<Range> ranges;
+  };
+
+  TextBatch text_batch_;
+
   const TextureBuffer2D black_texture_;
   const TextureBuffer2D white_texture_;
   const TextureBuffer2D brdf_lut_texture_;
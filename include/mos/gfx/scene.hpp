@@ -8,6 +8,7 @@
 #include <mos/gfx/target.hpp>
 #include <mos/gfx/boxes.hpp>
 #include <mos/gfx/particle_clouds.hpp>
+#include <mos/gfx/texts.hpp>
 #include <mos/gfx/cube_camera.hpp>
 #include <mos/gfx/environment_lights.hpp>
 #include <mos/gfx/texture_targets.hpp>
@@ -21,6 +22,11 @@ namespace gfx {
 /** Scene for rendering. */
 class Scene {
 public:
+  /** Depth-only pass of opaque models before shading, so each pixel is shaded once. */
+  enum class DepthPrepass {
+    OFF, ON, AUTO
+  };
+
   Scene();
   Scene(const Models &models,
         const Camera &camera,
@@ -37,6 +43,15 @@ public:
   Fog fog;
   EnvironmentLights environment_lights;
   TextureTargets texture_targets;
+
+  /** Unlit texts, batched per font atlas. Put texts in models instead to have them lit. */
+  Texts texts;
+
+  /** AUTO enables the pre-pass when measured overdraw is high. */
+  DepthPrepass depth_prepass;
+
+  /** Skip models hidden behind others, tested on the GPU against a depth pyramid. */
+  bool occlusion_culling;
 };
 }
 }
\ No newline at end of file
@@ -0,0 +1,43 @@
+#pragma once
+#include <mos/core/span.hpp>
+#include <mos/gfx/scene.hpp>
+
+namespace mos {
+namespace gfx {
+
+/**
+ * What the renderer reads from a scene, without owning or copying models,
+ * particles, boxes, texts or texture targets. Camera, lights and fog are
+ * small and held by value. Everything viewed must stay unchanged until the
+ * render call returns.
+ */
+class SceneView {
+public:
+  SceneView();
+
+  /** View of a whole scene. */
+  SceneView(const Scene &scene);
+
+  SceneView(Span<const Model> models,
+            const Camera &camera,
+            const Lights &lights = Lights(),
+            const Fog &fog = Fog(),
+            const EnvironmentLights &environment_lights = EnvironmentLights());
+
+  Span<const Model> models;
+  Span<const ParticleCloud> particle_clouds;
+  Span<const Box> boxes;
+  Span<const TextureTarget> texture_targets;
+  Span<const Text> texts;
+  Lights lights;
+  Camera camera;
+  Fog fog;
+  EnvironmentLights environment_lights;
+  Scene::DepthPrepass depth_prepass;
+  bool occlusion_culling;
+};
+
+/** Scenes to render, first scene decides shadows, environment and texture targets. */
+using SceneViews = Span<const SceneView>;
+}
+}
@@ -22,6 +22,13 @@ public:
        bool emissive = false,
        float spacing = 0.0f);
 
+  /** Texts sharing a font are cheap to copy. */
+  Text(const std::string &text,
+       const SharedFont &font,
+       const glm::mat4 &transform = glm::mat4(1.0f),
+       bool emissive = false,
+       float spacing = 0.0f);
+
   virtual ~Text();
 
   /** Set text. */
@@ -57,7 +64,10 @@ public:
   glm::mat4 transform() const;
 
   /** Get model. */
-  Model model() const;
+  const Model &model() const;
+
+  /** Colour and opacity the glyphs are multiplied with, when drawn in a text batch. */
+  glm::vec4 color() const;
 
   /** Set if the text is emissive. */
   void emissive(bool emissive);
@@ -72,7 +82,7 @@ public:
   void emission_strength(float strength);
 
   /** Get the font. */
-  Font font() const;
+  const Font &font() const;
 
   float spacing;
 
@@ -81,9 +91,14 @@ public:
   Text &operator+=(const std::string &text);
 
 private:
+  /**
+   * Write a quad per character into the mesh in one pass. Characters missing
+   * from the font are skipped.
+   */
+  void layout();
   Model model_;
   std::string text_;
-  Font font_;
+  SharedFont font_;
 };
 }
 }
\ No newline at end of file
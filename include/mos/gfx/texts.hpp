@@ -0,0 +1,13 @@
+#pragma once
+
+#include <mos/core/container.hpp>
+#include <mos/gfx/text.hpp>
+
+namespace mos {
+namespace gfx {
+
+/** Collection of texts. */
+using Texts = Container<Text>;
+
+}
+}
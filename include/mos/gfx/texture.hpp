@@ -1,5 +1,6 @@
 #pragma once
 #include <vector>
+#include <string>
 #include <atomic>
 #include <initializer_list>
 #include <memory>
@@ -22,7 +23,16 @@ public:
     RGB,
     RGBA,
     SRGB,
-    SRGBA
+    SRGBA,
+    /** Block compressed, 4x4 texels per block. */
+    BC1,
+    BC1_SRGB,
+    BC3,
+    BC3_SRGB,
+    BC4,
+    BC5,
+    BC7,
+    BC7_SRGB
   };
   template<class T>
   Texture(T begin, T end,
@@ -30,16 +40,19 @@ public:
           const int height,
           const Format &format = Format::SRGBA,
           const Wrap &wrap = Wrap::REPEAT,
-          const bool mipmaps = true) : layers(begin, end),
-                                       width_(width), height_(height),
-                                       format(format), wrap(wrap), mipmaps(mipmaps), id_(current_id_++) {};
+          const bool mipmaps = true,
+          const int levels = 1) : layers(begin, end),
+                                  width_(width), height_(height),
+                                  format(format), wrap(wrap), mipmaps(mipmaps), levels(levels),
+                                  id_(current_id_++) {};
 
   Texture(const std::initializer_list<Data> &layers,
           int width,
           int height,
           const Format &format = Format::SRGBA,
           const Wrap &wrap = Wrap::REPEAT,
-          bool mipmaps = true);
+          bool mipmaps = true,
+          int levels = 1);
 
   Texture(int width,
           int height,
@@ -47,19 +60,43 @@ public:
           const Wrap &wrap = Wrap::REPEAT,
           bool mipmaps = true);
 
+  /** Load from *.png or *.texture files, one or more layers each. */
   Texture(const std::initializer_list<std::string> &paths,
           bool color_data,
           const Wrap &wrap,
           bool mipmaps);
 
+  /** True for the block compressed formats. */
+  static bool compressed(const Format &format);
+
+  /** True for the formats with an alpha channel. */
+  static bool alpha(const Format &format);
+
+  /** Bytes in one level of one layer. */
+  static size_t size(const Format &format, int width, int height);
+
   int id() const;
   int width() const;
   int height() const;
   int depth() const;
 
+  int width(int level) const;
+  int height(int level) const;
+
+  /** Byte offset of a level within each layer. */
+  size_t offset(int level) const;
+
+  /** Save as a *.texture container with all levels. */
+  void save(const std::string &path) const;
+
   bool mipmaps; // TODO: const
   Wrap wrap; // TODO: const
   Format format; // TODO: const
+  /**
+   * Mip levels stored in each layer, largest first. With a single level,
+   * the rest are generated on upload if mipmaps is set.
+   */
+  int levels;
   TrackedContainer<Data> layers;
 private:
   static std::atomic_uint current_id_;
@@ -67,6 +104,7 @@ private:
   int width_;
   int height_;
 
+  void load_container(const std::string &path);
 };
 }
 }
@@ -19,8 +19,9 @@ public:
   template<class T>
   Texture2D(T begin, T end, unsigned int width, unsigned int height,
             const Format &format = Format::SRGBA, const Wrap &wrap = Wrap::REPEAT,
-            const bool mipmaps = true)
-      : Texture({Data(begin, end)}, width, height, format, wrap, mipmaps) {}
+            const bool mipmaps = true,
+            const int levels = 1)
+      : Texture({Data(begin, end)}, width, height, format, wrap, mipmaps, levels) {}
 
    Texture2D(unsigned int width, unsigned int height,
             const Format &format = Format::SRGBA,
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <mos/gfx/texture.hpp>
+#include <mos/gfx/texture_2d.hpp>
+
+namespace mos {
+namespace gfx {
+
+/** How mip levels are filtered from the level above. */
+enum class MipFilter {
+  /** Plain average, for data like roughness or masks. */
+  LINEAR,
+  /** Average in linear space, colour channels are sRGB encoded. */
+  SRGB,
+  /** Average of unit vectors in RG(B), renormalized. */
+  NORMAL
+};
+
+/** Half size RGBA8 image, box filtered. */
+Texture::Data downsample(const Texture::Data &rgba, int width, int height,
+                         const MipFilter &filter = MipFilter::LINEAR);
+
+/** Encode RGBA8 pixels into one level of any texture format. */
+Texture::Data encode(const Texture::Data &rgba, int width, int height, const Texture::Format &format);
+
+/**
+ * Texture from RGBA8 pixels, with all mip levels filtered on the CPU if
+ * mipmaps is set. Slow for block compressed formats, meant for offline tools.
+ */
+SharedTexture2D build_texture(const Texture::Data &rgba,
+                              int width,
+                              int height,
+                              const Texture::Format &format,
+                              const MipFilter &filter,
+                              bool mipmaps = true,
+                              const Texture::Wrap &wrap = Texture::Wrap::REPEAT);
+}
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <glm/glm.hpp>
+#include <mos/gfx/vertex.hpp>
+
+namespace mos {
+namespace gfx {
+
+/**
+ * How the vertices of a mesh are stored in GPU memory. Meshes keep full
+ * precision vertices, and are packed to their layout when loaded. Quantized
+ * positions are 16 bit fractions of the mesh bounds, octahedral normals and
+ * tangents are two 16 bit components, and uvs and weights are half floats.
+ */
+class VertexLayout final {
+public:
+  enum class Position { FLOAT, QUANTIZED };
+  enum class Direction { FLOAT, OCTAHEDRAL };
+  enum class Uv { FLOAT, HALF };
+
+  /** Component type of an attribute, the 16 bit integers are normalized. */
+  enum class Type { FLOAT, HALF, UNORM16, SNORM16 };
+
+  struct Attribute {
+    int components;
+    Type type;
+    size_t offset;
+  };
+
+  /** Position, normal, tangent, uv and weight, in shader location order. */
+  using Attributes = std::array<Attribute, 5>;
+
+  explicit VertexLayout(Position position = Position::FLOAT,
+                        Direction direction = Direction::FLOAT,
+                        Uv uv = Uv::FLOAT);
+
+  /** Every attribute packed, 20 bytes per vertex instead of 48. */
+  static VertexLayout packed();
+
+  Attributes attributes() const;
+
+  /** Bytes per vertex. */
+  size_t stride() const;
+
+  /** Write vertices in this layout, stride() bytes each. Quantized positions span min to max. */
+  void pack(const Vertex *vertices, size_t count, const glm::vec3 &min, const glm::vec3 &max, void *out) const;
+
+  bool operator==(const VertexLayout &other) const;
+  bool operator!=(const VertexLayout &other) const;
+
+  Position position;
+
+  /** Of normals and tangents. */
+  Direction direction;
+
+  /** Of uvs and weights. */
+  Uv uv;
+};
+}
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include <functional>
+
+namespace mos {
+namespace io {
+
+/**
+ * OpenGL 4.3 core context without a window, created through EGL. Uses a
+ * surfaceless context when the driver supports it, otherwise a small pbuffer.
+ * Render with gfx::Renderer::render_offscreen, there is no default framebuffer
+ * to present to. Requires building with MOS_HEADLESS.
+ */
+class HeadlessContext final {
+public:
+  HeadlessContext();
+  HeadlessContext(const HeadlessContext &context) = delete;
+  HeadlessContext &operator=(const HeadlessContext &context) = delete;
+  ~HeadlessContext();
+
+  /** Make the context current on the calling thread. */
+  void make_current();
+
+  /**
+   * Create a second context that shares objects with this one. The returned
+   * function makes it current on the calling thread, or releases it with
+   * false, for gfx::Renderer::upload_async.
+   */
+  std::function<void(bool)> shared_context();
+
+private:
+  void create();
+  /** Release what create() got so far. */
+  void destroy();
+  void *display_;
+  void *config_;
+  void *context_;
+  void *surface_;
+  void *shared_context_;
+  void *shared_surface_;
+};
+}
+}
@@ -52,11 +52,19 @@ public:
   glm::dvec2 cursor_position() const;
   float dpi() const;
 
+  /**
+   * Create a hidden context that shares objects with the window. The returned
+   * function makes it current on the calling thread, or releases it with
+   * false, for gfx::Renderer::upload_async.
+   */
+  std::function<void(bool)> shared_context();
+
 private:
   GLFWwindow *window_;
   GLFWcursor *hand_cursor_;
   GLFWcursor *arrow_cursor_;
   GLFWcursor *crosshair_cursor_;
+  GLFWwindow *shared_window_ = nullptr;
 
   static void error_callback(int error, const char *description);
   static void position_callback(GLFWwindow *window, int x, int y);
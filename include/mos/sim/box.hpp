@@ -70,6 +70,9 @@ public:
 
   bool intersects(const Ray &ray) const;
 
+  /** Check if the line segment between two points passes through the box. */
+  bool intersects_segment(const glm::vec3 &start, const glm::vec3 &end) const;
+
   bool intersect2(const Box &other) const {
     auto mmax = max();
     auto mmin = min();
@@ -35,6 +35,9 @@ public:
 
   std::optional<gfx::Vertex>
   closest_intersection(const glm::vec3 &origin, const glm::vec3 &direction);
+  /** Check if the line segment between two points hits any triangle. */
+  bool intersects_segment(const glm::vec3 &start, const glm::vec3 &end) const;
+
   void calculate_normals();
 
   ~Navmesh();
@@ -1,19 +1,42 @@
+#include <algorithm>
 #include <mos/aud/assets.hpp>
+#include <mos/core/jobs.hpp>
 
 namespace mos {
 namespace aud {
 
-Assets::Assets(const std::string &directory) : directory_(directory) {}
+Assets::Assets(const std::string &directory,
+               const std::string &cache_directory)
+    : directory_(directory), cache_directory_(cache_directory) {}
 
 SharedBuffer Assets::audio_buffer(const std::string &path) {
   if (buffers_.find(path) == buffers_.end()) {
-    buffers_.insert(BufferPair(path, Buffer::load(directory_ + path)));
+    buffers_.insert(BufferPair(path, Buffer::load(directory_ + path, cache_directory_)));
     return buffers_.at(path);
   } else {
     return buffers_.at(path);
   }
 }
 
+void Assets::preload(const std::vector<std::string> &paths) {
+  std::vector<std::string> missing;
+  for (const auto &path : paths) {
+    if (buffers_.find(path) == buffers_.end() &&
+        std::find(missing.begin(), missing.end(), path) == missing.end()) {
+      missing.push_back(path);
+    }
+  }
+  std::vector<SharedBuffer> loaded(missing.size());
+  Jobs::parallel_for(0, missing.size(), 1, [&](const size_t begin, const size_t end) {
+    for (size_t i = begin; i < end; i++) {
+      loaded[i] = Buffer::load(directory_ + missing[i], cache_directory_);
+    }
+  });
+  for (size_t i = 0; i < missing.size(); i++) {
+    buffers_.insert(BufferPair(missing[i], loaded[i]));
+  }
+}
+
 void Assets::clear_unused() {
   for (auto it = buffers_.begin(); it != buffers_.end();) {
     if (it->second.use_count() <= 1) {
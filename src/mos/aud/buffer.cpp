@@ -1,7 +1,16 @@
 #include <stdexcept>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <mos/aud/buffer.hpp>
+#include <mos/core/mapped_file.hpp>
 #include <stb_vorbis.h>
 #include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <random>
+#include <filesystem/path.h>
+#include <mos/core/profiler.hpp>
 
 namespace mos {
 namespace aud {
@@ -10,26 +19,83 @@ std::atomic_uint Buffer::current_id_;
 
 Buffer::Buffer(const int channels) : channels_(channels), id_(current_id_++) {}
 
-Buffer::Buffer(const std::string &path) : id_(current_id_++) {
-  short *decoded;
-
-  std::ifstream file(path, std::ios::binary);
-  if (!file.good()) {
-    throw std::runtime_error(path + " does not exist.");
+/** Header of decoded PCM cache files. */
+struct PcmHeader {
+  char magic[4];
+  int32_t channels;
+  int32_t sample_rate;
+  uint64_t count;
+};
+
+static const char pcm_magic[4] = {'M', 'P', 'C', 'M'};
+
+Buffer::Buffer(const std::string &path, const std::string &cache_directory)
+    : id_(current_id_++) {
+  MOS_PROFILE_ZONE("aud::Buffer::Buffer");
+  MappedFile file(path);
+
+  std::string cache_path;
+  if (!cache_directory.empty()) {
+    std::stringstream ss;
+    ss << std::hex << std::setw(16) << std::setfill('0') << file.hash();
+    cache_path = (filesystem::path(cache_directory) / (ss.str() + ".pcm")).str();
+    if (filesystem::path(cache_path).exists()) {
+      MappedFile cache(cache_path);
+      PcmHeader header{};
+      if (cache.size() >= sizeof(header)) {
+        std::memcpy(&header, cache.data(), sizeof(header));
+        const auto *begin =
+            reinterpret_cast<const short *>(cache.data() + sizeof(header));
+        if (std::memcmp(header.magic, pcm_magic, sizeof(pcm_magic)) == 0 &&
+            cache.size() == sizeof(header) + header.count * sizeof(short)) {
+          channels_ = header.channels;
+          sample_rate_ = header.sample_rate;
+          samples_.assign(begin, begin + header.count);
+          return;
+        }
+      }
+    }
   }
-  std::vector<unsigned char> data;
 
-  unsigned char c;
-  while (file.read(reinterpret_cast<char *>(&c), sizeof(c))) {
-    data.push_back(c);
+  short *decoded;
+  auto length = stb_vorbis_decode_memory(file.data(), int(file.size()),
+                                         &channels_, &sample_rate_, &decoded);
+  if (length < 0) {
+    throw std::runtime_error("Could not decode " + path + ".");
+  }
+  samples_.assign(decoded, decoded + length * channels_);
+  std::free(decoded);
+
+  if (!cache_path.empty()) {
+    filesystem::create_directory(filesystem::path(cache_directory));
+    // Write to a temporary and rename, so a crash never leaves a torn entry.
+    // Writers in any process loading the same file each get their own temporary.
+    std::random_device random;
+    std::stringstream suffix;
+    suffix << std::hex << random() << random();
+    const auto temporary = cache_path + "." + suffix.str() + ".tmp";
+    std::ofstream out(temporary, std::ios::binary);
+    if (out.good()) {
+      PcmHeader header{};
+      std::memcpy(header.magic, pcm_magic, sizeof(pcm_magic));
+      header.channels = channels_;
+      header.sample_rate = sample_rate_;
+      header.count = samples_.size();
+      out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+      out.write(reinterpret_cast<const char *>(samples_.data()),
+                samples_.size() * sizeof(short));
+      out.close();
+      // Renaming onto an existing entry fails on some platforms, another writer finished first.
+      if (!out.good() || std::rename(temporary.c_str(), cache_path.c_str()) != 0) {
+        std::remove(temporary.c_str());
+      }
+    }
   }
-  auto length = stb_vorbis_decode_memory(data.data(), data.size(), &channels_,
-                                         &sample_rate_, &decoded);
-  samples_.assign(decoded, decoded + length);
 }
 
-SharedBuffer Buffer::load(const std::string &path) {
-  return std::make_shared<Buffer>(path);
+SharedBuffer Buffer::load(const std::string &path,
+                          const std::string &cache_directory) {
+  return std::make_shared<Buffer>(path, cache_directory);
 }
 
 Buffer::Samples::const_iterator Buffer::begin() const {
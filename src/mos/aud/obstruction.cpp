@@ -0,0 +1,82 @@
+#include <algorithm>
+#include <mos/aud/obstruction.hpp>
+#include <mos/core/jobs.hpp>
+
+namespace mos {
+namespace aud {
+
+Obstruction::Obstruction(const std::vector<sim::Box> &boxes,
+                         const size_t rays_per_frame, const float smoothing)
+    : rays_per_frame(rays_per_frame), smoothing(smoothing), boxes_(boxes),
+      cursor_(0), frame_(0) {}
+
+Obstruction::Obstruction(const sim::Navmesh &navmesh,
+                         const size_t rays_per_frame, const float smoothing)
+    : rays_per_frame(rays_per_frame), smoothing(smoothing), navmesh_(navmesh),
+      cursor_(0), frame_(0) {}
+
+bool Obstruction::occluded(const glm::vec3 &start,
+                           const glm::vec3 &end) const {
+  for (const auto &box : boxes_) {
+    if (box.intersects_segment(start, end)) {
+      return true;
+    }
+  }
+  return navmesh_ && navmesh_->intersects_segment(start, end);
+}
+
+void Obstruction::update(Scene &scene, const float dt) {
+  frame_++;
+
+  sources_.clear();
+  for (auto &bs : scene.buffer_sources) {
+    if (bs.source.playing) {
+      sources_.push_back(&bs.source);
+    }
+  }
+  for (auto &ss : scene.stream_sources) {
+    if (ss.source.playing) {
+      sources_.push_back(&ss.source);
+    }
+  }
+
+  rays_.clear();
+  const auto count = std::min(rays_per_frame, sources_.size());
+  for (size_t i = 0; i < count; i++) {
+    const auto *source = sources_[(cursor_ + i) % sources_.size()];
+    rays_.push_back(Ray{source->position, source->id(), false});
+  }
+  cursor_ = sources_.empty() ? 0 : (cursor_ + count) % sources_.size();
+
+  const auto origin = scene.listener.position;
+  auto cast = [&](const size_t begin, const size_t end) {
+    for (size_t i = begin; i < end; i++) {
+      rays_[i].hit = occluded(origin, rays_[i].end);
+    }
+  };
+  static const size_t grain = 16;
+  Jobs::parallel_for(0, rays_.size(), grain, cast);
+
+  for (const auto &ray : rays_) {
+    entries_[ray.id].target = ray.hit ? 1.0f : 0.0f;
+  }
+
+  const float amount = glm::clamp(smoothing * dt, 0.0f, 1.0f);
+  for (auto *source : sources_) {
+    auto it = entries_.find(source->id());
+    if (it != entries_.end()) {
+      it->second.frame = frame_;
+      source->obstructed += (it->second.target - source->obstructed) * amount;
+    }
+  }
+
+  for (auto it = entries_.begin(); it != entries_.end();) {
+    if (it->second.frame != frame_) {
+      it = entries_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+}
+}
@@ -1,3 +1,5 @@
+#include <algorithm>
+#include <cmath>
 #include <chrono>
 #include <glm/gtx/io.hpp>
 #include <iostream>
@@ -5,6 +7,7 @@
 
 #include <mos/aud/buffer_source.hpp>
 #include <mos/aud/renderer.hpp>
+#include <mos/core/profiler.hpp>
 
 #ifdef MOS_EFX
 
@@ -93,7 +96,7 @@ void init_efx() {
 namespace mos {
 namespace aud {
 
-Renderer::Renderer()
+Renderer::Renderer(const int max_voices)
     : reverb_properties(EFX_REVERB_PRESET_LIVINGROOM), reverb_effect(0),
       reverb_slot(0), lowpass_filter1(0), lowpass_filter2(0) {
   ALCint contextAttr[] = {ALC_FREQUENCY, 44100, ALC_HRTF_SOFT, ALC_TRUE, 0};
@@ -162,43 +165,134 @@ Renderer::Renderer()
   alFilterf(lowpass_filter2, AL_LOWPASS_GAINHF, 0.01f); // 0.01f
 #endif
 
+  ALCint mono_sources = 0;
+  alcGetIntegerv(device_, ALC_MONO_SOURCES, 1, &mono_sources);
+  const int count = mono_sources > 0 ? std::min(max_voices, int(mono_sources))
+                                     : max_voices;
+  alGetError();
+  for (int i = 0; i < count; i++) {
+    ALuint voice;
+    alGenSources(1, &voice);
+    if (alGetError() != AL_NO_ERROR) {
+      break;
+    }
+    voices_.push_back(voice);
+#ifdef MOS_EFX
+    alSource3i(voice, AL_AUXILIARY_SEND_FILTER, reverb_slot, 0,
+               AL_FILTER_NULL);
+    ALuint al_filter;
+    alGenFilters(1, &al_filter);
+    filters_.insert(SourcePair(voice, al_filter));
+    alFilteri(al_filter, AL_FILTER_TYPE, AL_FILTER_LOWPASS);
+    alSourcei(voice, AL_DIRECT_FILTER, al_filter);
+#endif
+  }
+  if (voices_.empty()) {
+    throw std::runtime_error("Could not create any OpenAL sources.");
+  }
+  free_voices_ = std::vector<ALuint>(voices_.rbegin(), voices_.rend());
+
+  time_ = Clock::now();
   listener(Listener());
 }
 
 Renderer::~Renderer() {
-  for (auto source : sources_) {
-    alSourceStop(source.second);
-    alDeleteSources(1, &source.second);
+  clear();
+  for (auto voice : voices_) {
+    alDeleteSources(1, &voice);
   }
-  for (auto buffer : buffers_) {
-    alDeleteBuffers(1, &buffer.second);
+#ifdef MOS_EFX
+  for (auto filter : filters_) {
+    alDeleteFilters(1, &filter.second);
   }
+#endif
   alcMakeContextCurrent(nullptr);
   alcDestroyContext(context_);
   alcCloseDevice(device_);
 }
 
-void Renderer::buffer_source(const BufferSource &buffer_source) {
+float Renderer::audibility(const Source &source, const Listener &listener) {
+  const float distance = glm::distance(source.position, listener.position);
+  return source.gain * (1.0f / glm::max(distance, 1.0f)) *
+      glm::clamp(1.0f - source.obstructed, 0.0f, 1.0f);
+}
 
-  //TODO: HACK, replace this!
-  float dt = 1.0f / 60.0f;
+Renderer::Channel &Renderer::channel(const Source &source) {
+  auto &channel = channels_[source.id()];
+  channel.frame = frame_;
+  channel.audible = false;
+  return channel;
+}
 
-  if (sources_.find(buffer_source.source.id()) == sources_.end()) {
-    ALuint al_source;
-    alGenSources(1, &al_source);
-    sources_.insert(SourcePair(buffer_source.source.id(), al_source));
+void Renderer::candidate(const Source &source, const Channel &channel,
+                         const float duration, const Listener &listener) {
+  if (!source.playing) {
+    return;
+  }
+  // A virtual source that played to its end has nothing left to resume.
+  if (!channel.voice && !source.loop && channel.offset >= duration) {
+    return;
+  }
+  candidates_.push_back(
+      Candidate{source.id(), source.priority, audibility(source, listener)});
+}
 
-#ifdef MOS_EFX
-    alSource3i(al_source, AL_AUXILIARY_SEND_FILTER, reverb_slot, 0,
-               AL_FILTER_NULL);
-    ALuint al_filter;
-    alGenFilters(1, &al_filter);
-    filters_.insert(SourcePair(buffer_source.source.id(), al_filter));
-    alFilteri(al_filter, AL_FILTER_TYPE, AL_FILTER_LOWPASS);
-    alSourcei(al_source, AL_DIRECT_FILTER, al_filter);
-#endif
+void Renderer::obstruct(const Source &source, Channel &channel) const {
+  const float gain = glm::clamp(1.0f - source.obstructed, 0.0f, 1.0f);
+  channel.gain = gain;
+  channel.gain_hf = gain;
+}
+
+bool Renderer::bind(const Source &source, Channel &channel) {
+  // Audible channels never outnumber the voices, once departed and virtualized channels released theirs.
+  if (free_voices_.empty()) {
+    return false;
   }
+  channel.voice = free_voices_.back();
+  free_voices_.pop_back();
+
+  ALuint al_source = channel.voice;
+  alSourcei(al_source, AL_LOOPING, source.loop);
+  alSourcef(al_source, AL_PITCH, source.pitch);
+  alSource3f(al_source, AL_POSITION, source.position.x, source.position.y,
+             source.position.z);
+  alSource3f(al_source, AL_VELOCITY, source.velocity.x, source.velocity.y,
+             source.velocity.z);
+  return true;
+}
 
+void Renderer::release(Channel &channel) {
+  ALuint al_source = channel.voice;
+  alSourceStop(al_source);
+  alSourcei(al_source, AL_BUFFER, 0);
+  if (channel.streaming) {
+    alDeleteBuffers(ALsizei(channel.stream_buffers.size()),
+                    channel.stream_buffers.data());
+    channel.streaming = false;
+  }
+  channel.buffer = 0;
+  channel.voice = 0;
+  free_voices_.push_back(al_source);
+}
+
+void Renderer::advance(const Source &source, Channel &channel,
+                       const float duration, const float dt) const {
+  if (!source.playing) {
+    channel.offset = 0.0f;
+    channel.resume = false;
+    return;
+  }
+  channel.offset += dt * source.pitch;
+  if (channel.offset >= duration) {
+    channel.offset = source.loop && duration > 0.0f
+                         ? std::fmod(channel.offset, duration)
+                         : duration;
+  }
+  channel.resume = true;
+}
+
+void Renderer::buffer_source(const BufferSource &buffer_source,
+                             Channel &channel) {
   auto buffer = buffer_source.buffer;
   auto format = buffer->channels() == 1 ? AL_FORMAT_MONO16 : AL_FORMAT_STEREO16;
   if (buffers_.find(buffer->id()) == buffers_.end()) {
@@ -212,10 +306,18 @@ void Renderer::buffer_source(const BufferSource &buffer_source) {
     }
     buffers_.insert(BufferPair(buffer->id(), al_buffer));
   }
-  alSourcei(sources_.at(buffer_source.source.id()), AL_BUFFER,
-            buffers_.at(buffer->id()));
 
-  ALuint al_source = sources_.at(buffer_source.source.id());
+  ALuint al_source = channel.voice;
+  if (channel.buffer != buffers_.at(buffer->id())) {
+    alSourceStop(al_source);
+    channel.buffer = buffers_.at(buffer->id());
+    alSourcei(al_source, AL_BUFFER, channel.buffer);
+    if (channel.resume) {
+      alSourcef(al_source, AL_SEC_OFFSET, channel.offset);
+      channel.resume = false;
+    }
+  }
+
   alSourcei(al_source, AL_LOOPING, buffer_source.source.loop);
   alSourcef(al_source, AL_PITCH, buffer_source.source.pitch);
   //alSourcef(al_source, AL_GAIN, buffer_source.source.gain);
@@ -225,22 +327,12 @@ void Renderer::buffer_source(const BufferSource &buffer_source) {
              buffer_source.source.velocity.y, buffer_source.source.velocity.z);
 
 #ifdef MOS_EFX
-  auto al_filter = filters_[buffer_source.source.id()];
-  ALfloat al_gain;
-  alGetFilterf(al_filter, AL_LOWPASS_GAIN, &al_gain);
-  auto error = glm::clamp((1.0f - buffer_source.source.obstructed), 0.0f, 1.0f) - al_gain;
-  float gain = al_gain + error * dt;
-
-  ALfloat al_gain_hf;
-  alGetFilterf(al_filter, AL_LOWPASS_GAINHF, &al_gain_hf);
-  auto error_hf = glm::clamp((1.0f - buffer_source.source.obstructed), 0.0f, 1.0f) - al_gain_hf;
-  float gain_hf = al_gain_hf + error_hf * dt;
-
-  alSourcef(al_source, AL_GAIN, gain * buffer_source.source.gain);
+  auto al_filter = filters_.at(al_source);
+  alSourcef(al_source, AL_GAIN, channel.gain * buffer_source.source.gain);
 
   alFilteri(al_filter, AL_FILTER_TYPE, AL_FILTER_LOWPASS);
-  alFilterf(al_filter, AL_LOWPASS_GAIN, gain);      // 0.5f
-  alFilterf(al_filter, AL_LOWPASS_GAINHF, gain_hf); // 0.01f
+  alFilterf(al_filter, AL_LOWPASS_GAIN, channel.gain);
+  alFilterf(al_filter, AL_LOWPASS_GAINHF, channel.gain_hf);
   alSourcei(al_source, AL_DIRECT_FILTER, al_filter);
 #endif
 
@@ -251,39 +343,15 @@ void Renderer::buffer_source(const BufferSource &buffer_source) {
     alSourcePlay(al_source);
   }
 
-  ALint type;
-  alGetSourcei(al_source, AL_SOURCE_TYPE, &type);
-
-  if (!buffer_source.source.playing && (state == AL_PLAYING)) {
-    alSourceStop(al_source);
-  }
-
   if (state == AL_STOPPED) {
     alSourceRewind(al_source);
   }
 }
 
-void Renderer::stream_source(const StreamSource &stream_source) {
-
-  float dt = 1.0f / 60.0f; // TODO: REMOVE HACK
-
-  if (sources_.find(stream_source.source.id()) == sources_.end()) {
-    ALuint al_source;
-    alGenSources(1, &al_source);
-    sources_.insert(SourcePair(stream_source.source.id(), al_source));
-
-#ifdef MOS_EFX
-    alSource3i(al_source, AL_AUXILIARY_SEND_FILTER, reverb_slot, 0,
-               AL_FILTER_NULL);
-    ALuint al_filter;
-    alGenFilters(1, &al_filter);
-    filters_.insert(SourcePair(stream_source.source.id(), al_filter));
-    alFilteri(al_filter, AL_FILTER_TYPE, AL_FILTER_LOWPASS);
-    alSourcei(al_source, AL_DIRECT_FILTER, al_filter);
-#endif
-  };
-
-  ALuint al_source = sources_.at(stream_source.source.id());
+void Renderer::stream_source(const StreamSource &stream_source,
+                             Channel &channel) {
+  MOS_PROFILE_ZONE("aud::Renderer::stream_source");
+  ALuint al_source = channel.voice;
   alSourcei(al_source, AL_LOOPING, stream_source.source.loop);
   alSourcef(al_source, AL_PITCH, stream_source.source.pitch);
   //alSourcef(al_source, AL_GAIN, stream_source.source.gain);
@@ -293,69 +361,57 @@ void Renderer::stream_source(const StreamSource &stream_source) {
              stream_source.source.velocity.y, stream_source.source.velocity.z);
 
 #ifdef MOS_EFX
-  auto al_filter = filters_[stream_source.source.id()];
-  ALfloat al_gain;
-  alGetFilterf(al_filter, AL_LOWPASS_GAIN, &al_gain);
-  auto error = glm::clamp((1.0f - stream_source.source.obstructed), 0.0f, 1.0f) - al_gain;
-  float gain = al_gain + error * dt;
-
-  ALfloat al_gain_hf;
-  alGetFilterf(al_filter, AL_LOWPASS_GAINHF, &al_gain_hf);
-  auto error_hf = glm::clamp((1.0f - stream_source.source.obstructed), 0.0f, 1.0f) - al_gain_hf;
-  float gain_hf = al_gain_hf + error_hf * dt;
-
-  alSourcef(al_source, AL_GAIN, gain * stream_source.source.gain);
+  auto al_filter = filters_.at(al_source);
+  alSourcef(al_source, AL_GAIN, channel.gain * stream_source.source.gain);
 
   alFilteri(al_filter, AL_FILTER_TYPE, AL_FILTER_LOWPASS);
-  alFilterf(al_filter, AL_LOWPASS_GAIN , gain);      // 0.5f
-  alFilterf(al_filter, AL_LOWPASS_GAINHF, gain_hf); // 0.01f
+  alFilterf(al_filter, AL_LOWPASS_GAIN, channel.gain);
+  alFilterf(al_filter, AL_LOWPASS_GAINHF, channel.gain_hf);
   alSourcei(al_source, AL_DIRECT_FILTER, al_filter);
 #endif
 
   ALenum state;
   alGetSourcei(al_source, AL_SOURCE_STATE, &state);
 
-  ALint processed = 0;
-  alGetSourcei(al_source, AL_BUFFERS_PROCESSED, &processed);
   ALuint buffer = 0;
-
-  if(stream_source.stream) {
-    auto format = stream_source.stream->channels() == 1 ? AL_FORMAT_MONO16 : AL_FORMAT_STEREO16;
-
-    ALuint buffers[4]; // TODO std array
-    if (stream_source.source.playing && (state != AL_PLAYING)) {
-      alGenBuffers(4, buffers);
-      int size = stream_source.stream->buffer_size;
-      for (int i = 0; i < 4; i++) {
-        alBufferData(
-            buffers[i], format, stream_source.stream->read().data(),
-            size * sizeof(ALshort), stream_source.stream->sample_rate());
-        alSourceQueueBuffers(al_source, 1, &buffers[i]);
-      }
-      alSourcePlay(al_source);
-      alSourcei(al_source, AL_STREAMING, AL_TRUE);
-    }
-
-    while (processed--) {
-      alSourceUnqueueBuffers(al_source, 1, &buffer);
-      auto samples = stream_source.stream->read();
-      int size = stream_source.stream->buffer_size;
-
-      alBufferData(buffer, format, samples.data(),
-                   size * sizeof(ALshort),
-                   stream_source.stream->sample_rate());
-      alSourceQueueBuffers(al_source, 1, &buffer);
+  auto stream = stream_source.stream;
+  auto format = stream->channels() == 1 ? AL_FORMAT_MONO16 : AL_FORMAT_STEREO16;
+  const int size = stream->buffer_size;
+
+  if (stream_source.source.playing && (state != AL_PLAYING)) {
+    if (!channel.streaming) {
+      alGenBuffers(ALsizei(channel.stream_buffers.size()),
+                   channel.stream_buffers.data());
+      channel.streaming = true;
+    } else {
+      // Starved or stopped, drop the old queue before refilling.
+      alSourceStop(al_source);
+      alSourcei(al_source, AL_BUFFER, 0);
     }
-    if (stream_source.source.loop && stream_source.stream->done()) {
-      stream_source.stream->seek_start();
+    if (channel.resume) {
+      stream->seek(channel.offset);
+      channel.resume = false;
     }
-    if (!stream_source.source.playing && (state == AL_PLAYING)) {
-      alSourceStop(al_source);
-      ALint count;
-      alGetSourcei(al_source, AL_BUFFERS_QUEUED, &count);
-      alSourceUnqueueBuffers(al_source, count, &buffer);
-      alDeleteBuffers(4, buffers);
+    for (auto &b : channel.stream_buffers) {
+      alBufferData(b, format, stream->read().data(), size * sizeof(ALshort),
+                   stream->sample_rate());
+      alSourceQueueBuffers(al_source, 1, &b);
     }
+    alSourcePlay(al_source);
+    alSourcei(al_source, AL_STREAMING, AL_TRUE);
+  }
+
+  ALint processed = 0;
+  alGetSourcei(al_source, AL_BUFFERS_PROCESSED, &processed);
+  while (processed--) {
+    alSourceUnqueueBuffers(al_source, 1, &buffer);
+    auto samples = stream->read();
+    alBufferData(buffer, format, samples.data(), size * sizeof(ALshort),
+                 stream->sample_rate());
+    alSourceQueueBuffers(al_source, 1, &buffer);
+  }
+  if (stream_source.source.loop && stream->done()) {
+    stream->seek_start();
   }
 }
 
@@ -394,26 +450,127 @@ void Renderer::listener(const Listener &listener) {
 }
 
 void Renderer::render(const Scene &scene) {
+  MOS_PROFILE_ZONE("aud::Renderer::render");
+  const auto now = Clock::now();
+  const float dt =
+      glm::clamp(std::chrono::duration<float>(now - time_).count(), 0.0f, 0.1f);
+  time_ = now;
+  frame_++;
+
   listener(scene.listener);
+
+  candidates_.clear();
   for (const auto &bs : scene.buffer_sources) {
-    buffer_source(bs);
+    auto &c = channel(bs.source);
+    if (bs.buffer) {
+      candidate(bs.source, c, bs.buffer->duration(), scene.listener);
+    }
   }
-  for (auto &ss : scene.stream_sources) {
-    stream_source(ss);
+  for (const auto &ss : scene.stream_sources) {
+    auto &c = channel(ss.source);
+    if (ss.stream) {
+      candidate(ss.source, c, ss.stream->duration(), scene.listener);
+    }
+  }
+
+  const auto count = std::min(candidates_.size(), voices_.size());
+  std::partial_sort(candidates_.begin(), candidates_.begin() + count,
+                    candidates_.end(),
+                    [](const Candidate &a, const Candidate &b) {
+                      return a.priority != b.priority
+                                 ? a.priority > b.priority
+                                 : a.audibility > b.audibility;
+                    });
+  for (size_t i = 0; i < count; i++) {
+    channels_.at(candidates_[i].id).audible = true;
+  }
+
+  // Sources that left the scene, their voices are handed out below.
+  for (auto it = channels_.begin(); it != channels_.end();) {
+    if (it->second.frame != frame_) {
+      if (it->second.voice) {
+        release(it->second);
+      }
+      it = channels_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+
+  // Virtualize first, so the freed voices can be handed out below.
+  for (const auto &bs : scene.buffer_sources) {
+    auto &c = channels_.at(bs.source.id());
+    if (c.voice && !c.audible) {
+      if (bs.source.playing) {
+        alGetSourcef(c.voice, AL_SEC_OFFSET, &c.offset);
+        c.resume = true;
+      }
+      release(c);
+    }
+  }
+  for (const auto &ss : scene.stream_sources) {
+    auto &c = channels_.at(ss.source.id());
+    if (c.voice && !c.audible) {
+      if (ss.source.playing && c.streaming) {
+        // Decoded position minus what is still queued but not yet heard.
+        ALint queued = 0;
+        ALint sample_offset = 0;
+        alGetSourcei(c.voice, AL_BUFFERS_QUEUED, &queued);
+        alGetSourcei(c.voice, AL_SAMPLE_OFFSET, &sample_offset);
+        const int frames = ss.stream->buffer_size / ss.stream->channels();
+        const float pending = float(queued * frames - sample_offset) /
+            float(ss.stream->sample_rate());
+        c.offset = glm::max(ss.stream->position() - pending, 0.0f);
+        c.resume = true;
+      }
+      release(c);
+    }
+  }
+
+  for (const auto &bs : scene.buffer_sources) {
+    auto &c = channels_.at(bs.source.id());
+    obstruct(bs.source, c);
+    if (c.audible && !c.voice && !bind(bs.source, c)) {
+      c.audible = false;
+    }
+    if (c.audible) {
+      buffer_source(bs, c);
+    } else if (bs.buffer) {
+      advance(bs.source, c, bs.buffer->duration(), dt);
+    }
+  }
+  for (const auto &ss : scene.stream_sources) {
+    auto &c = channels_.at(ss.source.id());
+    obstruct(ss.source, c);
+    if (c.audible && !c.voice && !bind(ss.source, c)) {
+      c.audible = false;
+    }
+    if (c.audible) {
+      stream_source(ss, c);
+    } else if (ss.stream) {
+      advance(ss.source, c, ss.stream->duration(), dt);
+    }
   }
 }
 
 void Renderer::clear() {
-  for (auto source : sources_) {
-    alSourceStop(source.second);
-    alDeleteSources(1, &source.second);
+  for (auto &channel : channels_) {
+    if (channel.second.voice) {
+      release(channel.second);
+    }
   }
   for (auto buffer : buffers_) {
     alDeleteBuffers(1, &buffer.second);
   }
-  sources_.clear();
+  channels_.clear();
   buffers_.clear();
 }
 
+size_t Renderer::voices() const { return voices_.size(); }
+
+size_t Renderer::active_voices() const {
+  return voices_.size() - free_voices_.size();
+}
+
 }
 }
@@ -8,9 +8,11 @@ std::atomic_uint Source::current_id_;
 Source::Source(const glm::vec3 &position,
                const glm::vec3 &velocity,
                          const float pitch, const float gain, const bool loop,
-                         const bool playing, const float obstructed)
+                         const bool playing, const float obstructed,
+                         const int priority)
     : position(position), velocity(velocity), pitch(pitch), gain(gain),
-      loop(loop), playing(playing), obstructed(obstructed), id_(current_id_++) {
+      loop(loop), playing(playing), obstructed(obstructed), priority(priority),
+      id_(current_id_++) {
 }
 
 Source::~Source() {}
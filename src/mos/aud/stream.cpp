@@ -1,4 +1,5 @@
 #include <mos/aud/stream.hpp>
+#include <mos/core/profiler.hpp>
 
 namespace mos {
 namespace aud {
@@ -16,6 +17,7 @@ Stream::Stream(const std::string &path)
 Stream::~Stream() { stb_vorbis_close(vorbis_stream_); }
 
 std::array<short, Stream::buffer_size> Stream::read() {
+  MOS_PROFILE_ZONE("aud::Stream::read");
   auto samples = std::array<short, Stream::buffer_size>();
 
   int size = 0;
@@ -45,6 +47,17 @@ void Stream::seek_start() {
   samples_left_ = size() * channels();
 }
 
+void Stream::seek(const float position) {
+  const auto sample = static_cast<unsigned int>(position * sample_rate());
+  stb_vorbis_seek(vorbis_stream_, sample);
+  samples_left_ = (int(size()) - int(sample)) * channels();
+}
+
+float Stream::position() const {
+  return float(int(size()) * channels() - samples_left_) /
+      float(channels() * sample_rate());
+}
+
 unsigned int Stream::id() const { return id_; }
 
 float Stream::duration() const {
@@ -0,0 +1,56 @@
+#include <cstdint>
+#include <mos/core/frame_allocator.hpp>
+
+namespace mos {
+
+FrameArena::FrameArena(const size_t capacity) : index_(0) {
+  for (auto &buffer : buffers_) {
+    buffer.data = std::make_unique<unsigned char[]>(capacity);
+    buffer.capacity = capacity;
+  }
+}
+
+void *FrameArena::allocate(const size_t size, const size_t alignment) {
+  auto &buffer = buffers_[index_];
+  const auto base = reinterpret_cast<uintptr_t>(buffer.data.get());
+  auto used = buffer.used.load(std::memory_order_relaxed);
+  while (true) {
+    const auto begin = (base + used + alignment - 1) & ~uintptr_t(alignment - 1);
+    const auto end = begin - base + size;
+    if (end > buffer.capacity) {
+      break;
+    }
+    if (buffer.used.compare_exchange_weak(used, end, std::memory_order_relaxed)) {
+      return reinterpret_cast<void *>(begin);
+    }
+  }
+
+  // Full, keep the memory until the buffer is reused.
+  std::lock_guard<std::mutex> lock(buffer.mutex);
+  buffer.overflow.push_back(std::make_unique<unsigned char[]>(size + alignment));
+  buffer.overflow_size += size + alignment;
+  const auto address = reinterpret_cast<uintptr_t>(buffer.overflow.back().get());
+  return reinterpret_cast<void *>((address + alignment - 1) & ~uintptr_t(alignment - 1));
+}
+
+void FrameArena::frame() {
+  index_ = (index_ + 1) % buffers_.size();
+  auto &buffer = buffers_[index_];
+  if (buffer.overflow_size > 0) {
+    buffer.capacity += buffer.overflow_size;
+    buffer.data = std::make_unique<unsigned char[]>(buffer.capacity);
+    buffer.overflow.clear();
+    buffer.overflow_size = 0;
+  }
+  buffer.used = 0;
+}
+
+size_t FrameArena::used() const {
+  const auto &buffer = buffers_[index_];
+  return buffer.used.load() + buffer.overflow_size;
+}
+
+size_t FrameArena::capacity() const {
+  return buffers_[index_].capacity;
+}
+}
@@ -0,0 +1,232 @@
+#include <condition_variable>
+#include <limits>
+#include <memory>
+#include <thread>
+#include <mos/core/jobs.hpp>
+
+namespace mos {
+
+namespace {
+constexpr size_t external = std::numeric_limits<size_t>::max();
+
+/** Queue index of the calling worker, external for other threads. */
+thread_local size_t worker_index = external;
+}
+
+struct Jobs::Task {
+  std::function<void()> function;
+  JobCounter *counter = nullptr;
+};
+
+/** Owner pushes and pops at the back, thieves take from the front. */
+struct Jobs::Queue {
+  void put(Task task);
+  bool take(Task &task, bool newest);
+  std::mutex mutex;
+  /** Ring buffer that only grows, so a steady load does not allocate. */
+  std::vector<Task> tasks;
+  size_t first = 0;
+  size_t count = 0;
+};
+
+struct Jobs::State {
+  State();
+  ~State();
+  void push(Task task);
+  /** Take a job, from the own queue first, then the shared queue, then from others. */
+  bool pop(Task &task);
+  void work(size_t index);
+  /** One per worker. */
+  std::vector<std::unique_ptr<Queue>> queues;
+  /** Jobs queued by threads that are not workers. */
+  Queue shared;
+  std::vector<std::thread> threads;
+  std::mutex mutex;
+  std::condition_variable condition;
+  /** Jobs in any queue. */
+  std::atomic_size_t queued{0};
+  std::atomic_size_t victim{0};
+  bool stop = false;
+};
+
+void Jobs::Queue::put(Task task) {
+  std::lock_guard<std::mutex> lock(mutex);
+  if (count == tasks.size()) {
+    std::vector<Task> grown(std::max<size_t>(tasks.size() * 2, 64));
+    for (size_t i = 0; i < count; i++) {
+      grown[i] = std::move(tasks[(first + i) % tasks.size()]);
+    }
+    tasks.swap(grown);
+    first = 0;
+  }
+  tasks[(first + count) % tasks.size()] = std::move(task);
+  count++;
+}
+
+bool Jobs::Queue::take(Task &task, const bool newest) {
+  std::lock_guard<std::mutex> lock(mutex);
+  if (count == 0) {
+    return false;
+  }
+  const size_t index = newest ? (first + count - 1) % tasks.size() : first;
+  task = std::move(tasks[index]);
+  tasks[index] = Task();
+  if (!newest) {
+    first = (first + 1) % tasks.size();
+  }
+  count--;
+  return true;
+}
+
+Jobs::State::State() {
+  // The thread that waits runs jobs too.
+  const size_t count = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+  for (size_t i = 0; i < count; i++) {
+    queues.push_back(std::make_unique<Queue>());
+  }
+  for (size_t i = 0; i < count; i++) {
+    threads.emplace_back(&State::work, this, i);
+  }
+}
+
+Jobs::State::~State() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stop = true;
+  }
+  condition.notify_all();
+  for (auto &thread : threads) {
+    thread.join();
+  }
+}
+
+void Jobs::State::push(Task task) {
+  auto &queue = worker_index == external ? shared : *queues[worker_index];
+  queue.put(std::move(task));
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    queued++;
+  }
+  condition.notify_one();
+}
+
+bool Jobs::State::pop(Task &task) {
+  if (queued.load() == 0) {
+    return false;
+  }
+  bool found = (worker_index != external && queues[worker_index]->take(task, true)) ||
+      shared.take(task, false);
+  const size_t start = victim++;
+  for (size_t i = 0; !found && i < queues.size(); i++) {
+    const size_t index = (start + i) % queues.size();
+    found = index != worker_index && queues[index]->take(task, false);
+  }
+  if (found) {
+    queued--;
+  }
+  return found;
+}
+
+void Jobs::State::work(const size_t index) {
+  worker_index = index;
+  while (true) {
+    Task task;
+    if (pop(task)) {
+      execute(task);
+      continue;
+    }
+    std::unique_lock<std::mutex> lock(mutex);
+    condition.wait(lock, [this]() { return stop || queued.load() > 0; });
+    if (stop) {
+      return;
+    }
+  }
+}
+
+Jobs::State &Jobs::state() {
+  static State state;
+  return state;
+}
+
+void Jobs::execute(Task &task) {
+  auto &counter = *task.counter;
+  std::exception_ptr exception;
+  try {
+    task.function();
+  } catch (...) {
+    exception = std::current_exception();
+  }
+  task.function = nullptr;
+
+  std::vector<std::pair<std::function<void()>, JobCounter *>> continuations;
+  bool finished = false;
+  {
+    // Held while counting down, so wait does not return before this is done.
+    std::lock_guard<std::mutex> lock(counter.mutex_);
+    if (exception && !counter.exception_) {
+      counter.exception_ = exception;
+    }
+    finished = --counter.count_ == 0;
+    if (finished) {
+      continuations.swap(counter.continuations_);
+    }
+  }
+  auto &s = state();
+  for (auto &continuation : continuations) {
+    s.push(Task{std::move(continuation.first), continuation.second});
+  }
+  if (finished) {
+    // Wake threads sleeping in wait, the lock orders this after their check.
+    {
+      std::lock_guard<std::mutex> lock(s.mutex);
+    }
+    s.condition.notify_all();
+  }
+}
+
+bool JobCounter::done() const {
+  return count_.load() == 0;
+}
+
+size_t Jobs::workers() {
+  return state().threads.size();
+}
+
+void Jobs::run(std::function<void()> job, JobCounter &counter) {
+  counter.count_++;
+  state().push(Task{std::move(job), &counter});
+}
+
+void Jobs::run_after(JobCounter &dependency, std::function<void()> job, JobCounter &counter) {
+  counter.count_++;
+  {
+    std::lock_guard<std::mutex> lock(dependency.mutex_);
+    if (dependency.count_.load() > 0) {
+      dependency.continuations_.emplace_back(std::move(job), &counter);
+      return;
+    }
+  }
+  state().push(Task{std::move(job), &counter});
+}
+
+void Jobs::wait(JobCounter &counter) {
+  auto &s = state();
+  while (counter.count_.load() > 0) {
+    Task task;
+    if (s.pop(task)) {
+      execute(task);
+      continue;
+    }
+    // Sleep until a job is queued or the last counted job is done.
+    std::unique_lock<std::mutex> lock(s.mutex);
+    s.condition.wait(lock, [&]() { return counter.count_.load() == 0 || s.queued.load() > 0; });
+  }
+  // The last job may still hold the lock while it takes continuations.
+  std::lock_guard<std::mutex> lock(counter.mutex_);
+  if (counter.exception_) {
+    auto exception = counter.exception_;
+    counter.exception_ = nullptr;
+    std::rethrow_exception(exception);
+  }
+}
+}
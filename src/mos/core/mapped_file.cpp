@@ -0,0 +1,73 @@
+#include <stdexcept>
+#include <fstream>
+#include <mos/core/mapped_file.hpp>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace mos {
+
+MappedFile::MappedFile(const std::string &path) : data_(nullptr), size_(0) {
+#ifndef _WIN32
+  const int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw std::runtime_error(path + " does not exist.");
+  }
+  struct stat info{};
+  if (fstat(fd, &info) < 0) {
+    close(fd);
+    throw std::runtime_error("Could not stat " + path + ".");
+  }
+  size_ = size_t(info.st_size);
+  if (size_ > 0) {
+    void *mapped = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapped == MAP_FAILED) {
+      close(fd);
+      throw std::runtime_error("Could not map " + path + ".");
+    }
+    madvise(mapped, size_, MADV_SEQUENTIAL);
+    data_ = static_cast<const unsigned char *>(mapped);
+  }
+  close(fd);
+#else
+  std::ifstream file(path, std::ios::binary | std::ios::ate);
+  if (!file.good()) {
+    throw std::runtime_error(path + " does not exist.");
+  }
+  fallback_.resize(size_t(file.tellg()));
+  file.seekg(0);
+  file.read(reinterpret_cast<char *>(fallback_.data()), fallback_.size());
+  data_ = fallback_.data();
+  size_ = fallback_.size();
+#endif
+}
+
+MappedFile::~MappedFile() {
+#ifndef _WIN32
+  if (data_) {
+    munmap(const_cast<unsigned char *>(data_), size_);
+  }
+#endif
+}
+
+const unsigned char *MappedFile::data() const { return data_; }
+
+size_t MappedFile::size() const { return size_; }
+
+const unsigned char *MappedFile::begin() const { return data_; }
+
+const unsigned char *MappedFile::end() const { return data_ + size_; }
+
+uint64_t MappedFile::hash() const {
+  uint64_t hash = 14695981039346656037ull;
+  for (size_t i = 0; i < size_; i++) {
+    hash ^= data_[i];
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+}
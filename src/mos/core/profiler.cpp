@@ -0,0 +1,139 @@
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string_view>
+#include <unordered_map>
+#include <json.hpp>
+#include <mos/core/profiler.hpp>
+
+namespace mos {
+
+namespace {
+
+/** Single producer, single consumer ring of events, one per thread. */
+struct ThreadBuffer {
+  static constexpr size_t capacity = 1 << 14;
+  std::array<Profiler::Event, capacity> events;
+  std::atomic_size_t head{0};
+  std::atomic_size_t tail{0};
+  unsigned int thread{0};
+};
+
+struct State {
+  std::mutex mutex;
+  std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+  std::deque<Profiler::Event> history;
+  size_t history_size = 1 << 16;
+  std::vector<Profiler::Summary> summary;
+};
+
+State &state() {
+  static State state;
+  return state;
+}
+
+ThreadBuffer &thread_buffer() {
+  thread_local std::shared_ptr<ThreadBuffer> buffer = [] {
+    auto buffer = std::make_shared<ThreadBuffer>();
+    auto &s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    buffer->thread = unsigned(s.buffers.size());
+    s.buffers.push_back(buffer);
+    return buffer;
+  }();
+  return *buffer;
+}
+}
+
+int64_t Profiler::now() {
+  using namespace std::chrono;
+  return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+void Profiler::record(const char *name, const int64_t start, const int64_t end) {
+  auto &buffer = thread_buffer();
+  const auto head = buffer.head.load(std::memory_order_relaxed);
+  if (head - buffer.tail.load(std::memory_order_acquire) >= ThreadBuffer::capacity) {
+    // Full, the collector has not run in a while. Drop the event.
+    return;
+  }
+  buffer.events[head % ThreadBuffer::capacity] = Event{name, start, end, buffer.thread};
+  buffer.head.store(head + 1, std::memory_order_release);
+}
+
+void Profiler::frame() {
+  auto &s = state();
+  std::lock_guard<std::mutex> lock(s.mutex);
+
+  // By contents, equal literals in different translation units may have different addresses.
+  std::unordered_map<std::string_view, Summary> zones;
+  for (auto &buffer : s.buffers) {
+    const auto head = buffer->head.load(std::memory_order_acquire);
+    auto tail = buffer->tail.load(std::memory_order_relaxed);
+    for (; tail != head; tail++) {
+      const auto &event = buffer->events[tail % ThreadBuffer::capacity];
+      auto &zone = zones[event.name];
+      zone.name = event.name;
+      zone.milliseconds += double(event.end - event.start) / 1.0e6;
+      zone.calls++;
+      if (s.history_size > 0) {
+        s.history.push_back(event);
+      }
+    }
+    buffer->tail.store(tail, std::memory_order_release);
+  }
+  while (s.history.size() > s.history_size) {
+    s.history.pop_front();
+  }
+
+  s.summary.clear();
+  for (const auto &zone : zones) {
+    s.summary.push_back(zone.second);
+  }
+  std::sort(s.summary.begin(), s.summary.end(),
+            [](const Summary &a, const Summary &b) {
+              return a.milliseconds > b.milliseconds;
+            });
+}
+
+std::vector<Profiler::Summary> Profiler::summary() {
+  auto &s = state();
+  std::lock_guard<std::mutex> lock(s.mutex);
+  return s.summary;
+}
+
+void Profiler::history(const size_t events) {
+  auto &s = state();
+  std::lock_guard<std::mutex> lock(s.mutex);
+  s.history_size = events;
+  while (s.history.size() > s.history_size) {
+    s.history.pop_front();
+  }
+}
+
+void Profiler::write_trace(const std::string &path) {
+  auto &s = state();
+  std::lock_guard<std::mutex> lock(s.mutex);
+  auto events = nlohmann::json::array();
+  for (const auto &event : s.history) {
+    events.push_back({{"name", event.name},
+                      {"cat", "cpu"},
+                      {"ph", "X"},
+                      {"pid", 0},
+                      {"tid", event.thread},
+                      {"ts", double(event.start) / 1000.0},
+                      {"dur", double(event.end - event.start) / 1000.0}});
+  }
+  std::ofstream file(path);
+  if (!file.good()) {
+    throw std::runtime_error("Could not open " + path + ".");
+  }
+  file << nlohmann::json{{"traceEvents", events}}.dump();
+}
+}
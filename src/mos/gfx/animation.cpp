@@ -4,6 +4,7 @@
 #include <mos/util.hpp>
 #include <mos/gfx/animation.hpp>
 #include <filesystem/path.h>
+#include <mos/core/profiler.hpp>
 
 namespace mos {
 namespace gfx {
@@ -63,6 +64,7 @@ void Animation::frame_rate(const unsigned int frame_rate) {
 unsigned int Animation::frame_rate() const { return frame_rate_; }
 
 void Animation::update(const float dt) {
+  MOS_PROFILE_ZONE("gfx::Animation::update");
   time_ += dt;
   if (frame() >= keyframes_.rbegin()->first) {
     time_ = 0;
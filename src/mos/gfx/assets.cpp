@@ -8,6 +8,7 @@
 #include <glm/gtx/matrix_decompose.hpp>
 #include <mos/util.hpp>
 #include <iostream>
+#include <mos/core/profiler.hpp>
 
 namespace mos {
 namespace gfx {
@@ -16,6 +17,7 @@ using namespace nlohmann;
 Assets::Assets(const std::string &directory) : directory_(directory) {}
 
 std::shared_ptr<Mesh> Assets::mesh(const std::string &path) {
+  MOS_PROFILE_ZONE("gfx::Assets::mesh");
   if (path.empty()){
     return SharedMesh(nullptr);
   }
@@ -30,9 +32,19 @@ Assets::texture(const std::string &path,
                       const bool color_data,
                       const bool mipmaps,
                       const Texture2D::Wrap &wrap) {
+  MOS_PROFILE_ZONE("gfx::Assets::texture");
   if (!path.empty()) {
     if (textures_.find(path) == textures_.end()) {
-      textures_.insert(TexturePair(path, Texture2D::load(directory_ + path, color_data, mipmaps, wrap)));
+      // Prefer a prebuilt *.texture container next to the source image.
+      auto full_path = directory_ + path;
+      const filesystem::path fpath = full_path;
+      if (fpath.extension() != "texture") {
+        const auto container = full_path.substr(0, full_path.size() - fpath.extension().size()) + "texture";
+        if (!fpath.extension().empty() && filesystem::path(container).exists()) {
+          full_path = container;
+        }
+      }
+      textures_.insert(TexturePair(path, Texture2D::load(full_path, color_data, mipmaps, wrap)));
     }
     return textures_.at(path);
   } else {
@@ -0,0 +1,113 @@
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+#include <mos/gfx/distance_field.hpp>
+#include <mos/core/jobs.hpp>
+
+namespace mos {
+namespace gfx {
+
+static int channels(const Texture::Format &format) {
+  switch (format) {
+    case Texture::Format::R: return 1;
+    case Texture::Format::RG: return 2;
+    case Texture::Format::RGB:
+    case Texture::Format::SRGB: return 3;
+    default: return 4;
+  }
+}
+
+Font distance_field_font(const Font &font, const int downscale, const float spread) {
+  const auto &source = *font.texture;
+  if (Texture::compressed(source.format) || source.layers[0].empty()) {
+    throw std::runtime_error("Distance fields need an uncompressed font atlas in memory.");
+  }
+  if (downscale < 1 || source.width() % downscale != 0 || source.height() % downscale != 0) {
+    throw std::runtime_error("Font atlas size must be a multiple of the downscale factor.");
+  }
+  const int source_width = source.width();
+  const int source_height = source.height();
+  const int stride = channels(source.format);
+  // Coverage is in alpha when there is one.
+  const int channel = stride == 2 || stride == 4 ? stride - 1 : 0;
+  const auto &pixels = source.layers[0];
+  const auto covered = [&](const int x, const int y) {
+    return pixels[(size_t(y) * source_width + x) * stride + channel] >= 128;
+  };
+
+  const int width = source_width / downscale;
+  const int height = source_height / downscale;
+  Texture::Data distances(size_t(width) * height, 0);
+  const float scale = float(downscale);
+  const int radius = int(std::ceil(spread));
+
+  // Texels whose centre falls within a glyph belong to it, so glyphs write disjoint texels.
+  const auto generate = [&](const Character &character) {
+    const int x0 = std::clamp(int(character.x), 0, source_width);
+    const int y0 = std::clamp(int(character.y), 0, source_height);
+    const int x1 = std::clamp(int(character.x + character.width), x0, source_width);
+    const int y1 = std::clamp(int(character.y + character.height), y0, source_height);
+    const int tx0 = int(std::ceil(x0 / scale - 0.5f));
+    const int ty0 = int(std::ceil(y0 / scale - 0.5f));
+    const int tx1 = std::min(int(std::ceil(x1 / scale - 0.5f)), width);
+    const int ty1 = std::min(int(std::ceil(y1 / scale - 0.5f)), height);
+    for (int ty = ty0; ty < ty1; ty++) {
+      for (int tx = tx0; tx < tx1; tx++) {
+        const float px = (tx + 0.5f) * scale;
+        const float py = (ty + 0.5f) * scale;
+        const bool inside = covered(std::min(int(px), x1 - 1), std::min(int(py), y1 - 1));
+        // Outside the glyph rectangle counts as empty.
+        float nearest = inside ? std::min(std::min(px - x0, x1 - px), std::min(py - y0, y1 - py)) + 0.5f
+                               : spread + 0.5f;
+        for (int y = std::max(int(py) - radius, y0); y < std::min(int(py) + radius + 1, y1); y++) {
+          for (int x = std::max(int(px) - radius, x0); x < std::min(int(px) + radius + 1, x1); x++) {
+            if (covered(x, y) != inside) {
+              nearest = std::min(nearest, std::hypot(x + 0.5f - px, y + 0.5f - py));
+            }
+          }
+        }
+        // The edge is half a texel before the nearest texel of the other side.
+        const float distance = (inside ? 1.0f : -1.0f) * (nearest - 0.5f);
+        const float value = std::clamp(0.5f + distance / (2.0f * spread), 0.0f, 1.0f);
+        distances[size_t(ty) * width + tx] = static_cast<unsigned char>(std::lround(value * 255.0f));
+      }
+    }
+  };
+
+  std::vector<const Character *> characters;
+  for (const auto &pair : font.characters) {
+    // Characters sharing a glyph are generated once.
+    const auto &character = pair.second;
+    if (std::none_of(characters.begin(), characters.end(), [&](const Character *other) {
+      return other->x == character.x && other->y == character.y;
+    })) {
+      characters.push_back(&character);
+    }
+  }
+  Jobs::parallel_for(0, characters.size(), 1, [&](const size_t begin, const size_t end) {
+    for (size_t i = begin; i < end; i++) {
+      generate(*characters[i]);
+    }
+  });
+
+  auto atlas = std::make_shared<Texture2D>(distances.begin(), distances.end(), width, height,
+                                           Texture::Format::R, Texture::Wrap::CLAMP, false);
+  // Measures are in atlas texels, so they shrink with the atlas and the layout stays the same.
+  auto scaled = font.characters;
+  for (auto &pair : scaled) {
+    auto &character = pair.second;
+    character.x /= scale;
+    character.y /= scale;
+    character.width /= scale;
+    character.height /= scale;
+    character.x_offset /= scale;
+    character.y_offset /= scale;
+    character.x_advance /= scale;
+  }
+  Font result(scaled, atlas, font.height() / scale, font.base() / scale, 0.0f);
+  result.distance_field = true;
+  return result;
+}
+}
+}
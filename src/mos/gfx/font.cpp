@@ -8,8 +8,9 @@ namespace gfx {
 using namespace nlohmann;
 Font::Font(const Font::CharMap &characters, const SharedTexture2D &texture,
            const float height, const float ascender, const float descender)
-    : characters(characters), texture(texture), height_(height) {
+    : characters(characters), texture(texture), base_(ascender), height_(height) {
   texture->wrap = Texture2D::Wrap::CLAMP;
+  build_glyphs();
 }
 
 Font::Font(const std::string &path) {
@@ -32,6 +33,26 @@ Font::Font(const std::string &path) {
   height_ = doc["config"]["charHeight"];
   std::string texture_name = doc["config"]["textureFile"];
   texture = Texture2D::load(fpath.parent_path().str() + "/" + texture_name);
+  build_glyphs();
+}
+
+void Font::build_glyphs() {
+  const glm::vec2 texture_size(texture->width(), texture->height());
+  for (const auto &pair : characters) {
+    const auto &character = pair.second;
+    Glyph glyph;
+    glyph.offset = glm::vec2(character.x_offset, -(character.y_offset - base_)) / height_;
+    glyph.size = glm::vec2(character.width, -character.height) / height_;
+    glyph.advance = character.x_advance / height_;
+    glyph.uv_min = glm::vec2(character.x, character.y) / texture_size;
+    glyph.uv_max = glm::vec2(character.x + character.width, character.y + character.height) / texture_size;
+    glyph.valid = true;
+    glyphs_[static_cast<unsigned char>(pair.first)] = glyph;
+  }
+}
+
+const Font::Glyph &Font::glyph(const char character) const {
+  return glyphs_[static_cast<unsigned char>(character)];
 }
 
 float Font::height() const { return height_; }
@@ -0,0 +1,132 @@
+#include <fstream>
+#include <stdexcept>
+#include <json.hpp>
+#include <mos/gfx/gpu_profiler.hpp>
+
+namespace mos {
+namespace gfx {
+
+GpuProfiler::GpuProfiler()
+    : enabled(true), trace_frames(0), frame_(0), open_(false), resolved_frames_(0) {}
+
+GpuProfiler::~GpuProfiler() {
+  for (auto &frame : frames_) {
+    if (!frame.pool.empty()) {
+      glDeleteQueries(GLsizei(frame.pool.size()), frame.pool.data());
+    }
+  }
+}
+
+size_t GpuProfiler::query(Frame &frame) {
+  const auto used = frame.queries.size() * 2;
+  if (used + 2 > frame.pool.size()) {
+    const auto size = frame.pool.size();
+    frame.pool.resize(size + 16);
+    glGenQueries(16, frame.pool.data() + size);
+  }
+  return used;
+}
+
+void GpuProfiler::resolve(Frame &frame) {
+  if (frame.queries.empty()) {
+    return;
+  }
+  GLint available = 0;
+  glGetQueryObjectiv(frame.queries.back().end, GL_QUERY_RESULT_AVAILABLE, &available);
+  if (available) {
+    resolved_frames_++;
+    passes_.clear();
+    for (const auto &query : frame.queries) {
+      GLuint64 begin = 0;
+      GLuint64 end = 0;
+      glGetQueryObjectui64v(query.begin, GL_QUERY_RESULT, &begin);
+      glGetQueryObjectui64v(query.end, GL_QUERY_RESULT, &end);
+      passes_.push_back(PassTiming{query.name, begin, double(end - begin) / 1.0e6,
+                                   query.draws, query.triangles});
+    }
+    if (trace_frames > 0) {
+      history_.push_back(passes_);
+      while (history_.size() > trace_frames) {
+        history_.pop_front();
+      }
+    }
+  }
+  // Not available after a full ring means the GPU is far behind, drop the frame.
+  frame.queries.clear();
+}
+
+void GpuProfiler::begin_frame() {
+  if (open_) {
+    end();
+  }
+  frame_ = (frame_ + 1) % frames_.size();
+  resolve(frames_[frame_]);
+}
+
+void GpuProfiler::begin(const char *name) {
+  if (!enabled) {
+    return;
+  }
+  if (open_) {
+    end();
+  }
+  auto &frame = frames_[frame_];
+  const auto index = query(frame);
+  frame.queries.push_back(Query{name, frame.pool[index], frame.pool[index + 1], 0, 0});
+  glQueryCounter(frame.queries.back().begin, GL_TIMESTAMP);
+  open_ = true;
+}
+
+void GpuProfiler::end() {
+  if (!open_) {
+    return;
+  }
+  glQueryCounter(frames_[frame_].queries.back().end, GL_TIMESTAMP);
+  open_ = false;
+}
+
+void GpuProfiler::draw(const unsigned int triangles) {
+  if (open_) {
+    auto &query = frames_[frame_].queries.back();
+    query.draws++;
+    query.triangles += triangles;
+  }
+}
+
+const GpuProfiler::Passes &GpuProfiler::passes() const { return passes_; }
+
+double GpuProfiler::frame_milliseconds() const {
+  double total = 0.0;
+  for (const auto &pass : passes_) {
+    total += pass.milliseconds;
+  }
+  return total;
+}
+
+uint64_t GpuProfiler::resolved_frames() const { return resolved_frames_; }
+
+void GpuProfiler::write_trace(const std::string &path) const {
+  auto events = nlohmann::json::array();
+  const GLuint64 origin = history_.empty() || history_.front().empty()
+                              ? 0 : history_.front().front().start;
+  for (const auto &passes : history_) {
+    for (const auto &pass : passes) {
+      events.push_back({{"name", pass.name},
+                        {"cat", "gpu"},
+                        {"ph", "X"},
+                        {"pid", 0},
+                        {"tid", "gpu"},
+                        {"ts", double(pass.start - origin) / 1000.0},
+                        {"dur", pass.milliseconds * 1000.0},
+                        {"args", {{"draws", pass.draws},
+                                  {"triangles", pass.triangles}}}});
+    }
+  }
+  std::ofstream file(path);
+  if (!file.good()) {
+    throw std::runtime_error("Could not open " + path + ".");
+  }
+  file << nlohmann::json{{"traceEvents", events}}.dump();
+}
+}
+}
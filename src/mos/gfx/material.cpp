@@ -73,6 +73,15 @@ Material::Material(Assets &assets, std::string &path) : Material() {
         else if (normal_map->format == Texture::Format::SRGBA){
           normal_map->format = Texture::Format::RGBA;
         }
+        else if (normal_map->format == Texture::Format::BC1_SRGB){
+          normal_map->format = Texture::Format::BC1;
+        }
+        else if (normal_map->format == Texture::Format::BC3_SRGB){
+          normal_map->format = Texture::Format::BC3;
+        }
+        else if (normal_map->format == Texture::Format::BC7_SRGB){
+          normal_map->format = Texture::Format::BC7;
+        }
       }
       metallic_map = read_texture("metallic_map");
       roughness_map = read_texture("roughness_map");
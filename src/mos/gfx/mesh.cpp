@@ -7,6 +7,7 @@
 #include <glm/gtx/normal.hpp>
 #include <glm/gtx/io.hpp>
 #include <glm/gtx/io.hpp>
+#include <mos/core/profiler.hpp>
 
 namespace mos {
 namespace gfx {
@@ -17,6 +18,7 @@ Mesh::Mesh(const std::initializer_list<Vertex> &vertices,
 }
 
 Mesh::Mesh(const std::string &path) {
+  MOS_PROFILE_ZONE("gfx::Mesh::Mesh");
   if (path.substr(path.find_last_of(".") + 1) == "mesh") {
     std::ifstream is(path, std::ios::binary);
     if (!is.good()) {
@@ -51,7 +53,9 @@ Mesh::Mesh() {}
 
 Mesh::Mesh(const Mesh &mesh)
     : Mesh(mesh.vertices.begin(), mesh.vertices.end(), mesh.triangles.begin(),
-           mesh.triangles.end()) {}
+           mesh.triangles.end()) {
+  layout = mesh.layout;
+}
 
 SharedMesh Mesh::load(const std::string &path) {
   if (path.empty() || (path.back() == '/')) {
@@ -75,6 +79,7 @@ Mesh::Positions Mesh::positions() const {
 }
 
 void Mesh::mix(const Mesh &mesh1, const Mesh &mesh2, const float amount) {
+  MOS_PROFILE_ZONE("gfx::Mesh::mix");
   auto it = vertices.begin();
   auto it1 = mesh1.vertices.begin();
   auto it2 = mesh2.vertices.begin();
@@ -91,6 +96,7 @@ void Mesh::mix(const Mesh &mesh1, const Mesh &mesh2, const float amount) {
 }
 
 void Mesh::apply_transform(const glm::mat4 &transform) {
+  MOS_PROFILE_ZONE("gfx::Mesh::apply_transform");
   for (auto &vertex : vertices) {
     vertex.position = glm::vec3(transform * glm::vec4(vertex.position, 1.0f));
   }
@@ -127,6 +133,7 @@ void Mesh::calculate_tangents(Vertex &v0,
 
 
 void Mesh::calculate_normals() {
+  MOS_PROFILE_ZONE("gfx::Mesh::calculate_normals");
   if (triangles.size() == 0) {
     for (size_t i = 0; i < vertices.size(); i += 3) {
       //TODO: Generalize
@@ -184,6 +191,7 @@ void Mesh::calculate_normals() {
 }
 
 void Mesh::calculate_tangents() {
+  MOS_PROFILE_ZONE("gfx::Mesh::calculate_tangents");
   if (triangles.size() == 0) {
     for (size_t i = 0; i < vertices.size(); i += 3) {
       //TODO: Generalize
@@ -204,6 +212,7 @@ void Mesh::calculate_tangents() {
   }
 }
 void Mesh::calculate_flat_normals() {
+  MOS_PROFILE_ZONE("gfx::Mesh::calculate_flat_normals");
   if (triangles.size() == 0) {
     for (size_t i = 0; i < vertices.size(); i += 3) {
       auto &v0 = vertices[i];
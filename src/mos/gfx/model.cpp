@@ -4,6 +4,7 @@
 #include <mos/util.hpp>
 #include <mos/gfx/material.hpp>
 #include <glm/gtx/io.hpp>
+#include <mos/core/profiler.hpp>
 
 namespace mos {
 namespace gfx {
@@ -13,6 +14,7 @@ Model::Model(const std::string &name, const SharedMesh &mesh,
     : mesh(mesh), material(material), name_(name), transform(transform) {}
 
 Model::Model(Assets &assets, const nlohmann::json &json, const glm::mat4 &parent_transform) {
+  MOS_PROFILE_ZONE("gfx::Model::Model");
   auto parsed = json;
   if (parsed.is_string()) {
     std::cout << "Loading: " << parsed << std::endl;
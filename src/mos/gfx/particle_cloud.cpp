@@ -1,5 +1,6 @@
 #include <mos/gfx/particle_cloud.hpp>
 #include <algorithm>
+#include <mos/core/profiler.hpp>
 
 namespace mos {
 namespace gfx {
@@ -11,6 +12,7 @@ ParticleCloud::ParticleCloud(const SharedTexture2D& emission_map, const Particle
 emission_map(emission_map), particles(particles) {}
 
 void ParticleCloud::sort(const glm::vec3 &position) {
+  MOS_PROFILE_ZONE("gfx::ParticleCloud::sort");
   std::sort(particles.begin(), particles.end(),
             [&](const Particle &a, const Particle &b) -> bool {
               auto a_distance1 = glm::distance(a.position, position);
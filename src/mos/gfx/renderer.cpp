@@ -10,11 +10,21 @@
 #include <glm/gtx/transform2.hpp>
 #include <iostream>
 #include <map>
+#include <limits>
 #include <memory>
+#include <cstring>
+#include <atomic>
+#include <cstddef>
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
 #include <mos/gfx/mesh.hpp>
 #include <mos/gfx/model.hpp>
 #include <mos/gfx/renderer.hpp>
 #include <mos/util.hpp>
+#include <mos/core/profiler.hpp>
+#include <mos/core/jobs.hpp>
+#include <mos/core/frame_allocator.hpp>
 
 namespace mos {
 namespace gfx {
@@ -26,6 +36,14 @@ GLuint wrap_convert(const Texture::Wrap &wrap) {
   return wrap_map.at(wrap);
 }
 
+// From EXT_texture_compression_s3tc and EXT_texture_sRGB, which the loader does not include.
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#define GL_COMPRESSED_SRGB_S3TC_DXT1_EXT 0x8C4C
+#define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT 0x8C4F
+#endif
+
 struct FormatPair {
   GLuint internal_format;
   GLuint format;
@@ -38,10 +56,142 @@ FormatPair format_convert(const Texture::Format &format) {
       {Texture::Format::SRGB, {GL_SRGB, GL_RGB}},
       {Texture::Format::SRGBA, {GL_SRGB_ALPHA, GL_RGBA}},
       {Texture::Format::RGB, {GL_RGB, GL_RGB}},
-      {Texture::Format::RGBA, {GL_RGBA, GL_RGBA}}};
+      {Texture::Format::RGBA, {GL_RGBA, GL_RGBA}},
+      {Texture::Format::BC1, {GL_COMPRESSED_RGB_S3TC_DXT1_EXT, GL_RGB}},
+      {Texture::Format::BC1_SRGB, {GL_COMPRESSED_SRGB_S3TC_DXT1_EXT, GL_RGB}},
+      {Texture::Format::BC3, {GL_COMPRESSED_RGBA_S3TC_DXT5_EXT, GL_RGBA}},
+      {Texture::Format::BC3_SRGB, {GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT, GL_RGBA}},
+      {Texture::Format::BC4, {GL_COMPRESSED_RED_RGTC1, GL_RED}},
+      {Texture::Format::BC5, {GL_COMPRESSED_RG_RGTC2, GL_RG}},
+      {Texture::Format::BC7, {GL_COMPRESSED_RGBA_BPTC_UNORM, GL_RGBA}},
+      {Texture::Format::BC7_SRGB, {GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM, GL_RGBA}}};
   return format_map.at(format);
 }
 
+/** Pixels of one level in memory, null when the texture has no data. */
+const void *level_data(const Texture2D &texture, const int level) {
+  const auto &data = texture.layers[0];
+  return data.empty() ? nullptr : data.data() + texture.offset(level);
+}
+
+/** Upload one level of a texture to the bound GL_TEXTURE_2D. */
+void upload_texture_level(const Texture2D &texture, const int level, const void *pixels) {
+  const auto format = format_convert(texture.format);
+  // Rows of small or odd sized levels are tightly packed.
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  if (Texture::compressed(texture.format)) {
+    glCompressedTexImage2D(GL_TEXTURE_2D, level, format.internal_format,
+                           texture.width(level), texture.height(level), 0,
+                           Texture::size(texture.format, texture.width(level), texture.height(level)),
+                           pixels);
+  } else {
+    glTexImage2D(GL_TEXTURE_2D, level, format.internal_format,
+                 texture.width(level), texture.height(level), 0,
+                 format.format, GL_UNSIGNED_BYTE, pixels);
+  }
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
+
+/**
+ * Upload levels from base_level and down to the bound GL_TEXTURE_2D. With
+ * unpack_buffer the levels are read from the bound GL_PIXEL_UNPACK_BUFFER,
+ * which starts at base_level.
+ */
+void upload_texture_2d(const Texture2D &texture, const int base_level = 0, const bool unpack_buffer = false) {
+  for (int level = base_level; level < texture.levels; level++) {
+    const void *pixels = unpack_buffer
+                         ? reinterpret_cast<const void *>(texture.offset(level) - texture.offset(base_level))
+                         : level_data(texture, level);
+    upload_texture_level(texture, level, pixels);
+  }
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, base_level);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, texture.levels > 1 ? texture.levels - 1 : 1000);
+  if (texture.mipmaps && texture.levels == 1) {
+    glGenerateMipmap(GL_TEXTURE_2D);
+  }
+}
+
+/** Create a GL texture with its sampling parameters and levels from base_level and down. */
+GLuint create_texture(const Texture2D &texture, const int base_level, const bool unpack_buffer = false) {
+  GLuint id;
+  glGenTextures(1, &id);
+  glBindTexture(GL_TEXTURE_2D, id);
+
+  const auto filter = texture.mipmaps || texture.levels > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR;
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrap_convert(texture.wrap));
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, wrap_convert(texture.wrap));
+
+  upload_texture_2d(texture, base_level, unpack_buffer);
+  glBindTexture(GL_TEXTURE_2D, 0);
+  return id;
+}
+
+/** Buffer object with a copy of data, written through a mapping. */
+GLuint create_buffer(const void *data, const size_t size) {
+  GLuint id;
+  glGenBuffers(1, &id);
+  // Element array bindings belong to a vertex array, use a generic target.
+  glBindBuffer(GL_COPY_WRITE_BUFFER, id);
+  glBufferData(GL_COPY_WRITE_BUFFER, size, nullptr, GL_STATIC_DRAW);
+  if (size > 0) {
+    void *destination = glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, size,
+                                         GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    if (!destination) {
+      glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+      glDeleteBuffers(1, &id);
+      throw std::runtime_error("Could not map buffer of " + std::to_string(size) + " bytes.");
+    }
+    std::memcpy(destination, data, size);
+    glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+  }
+  glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+  return id;
+}
+
+/** Vertices of a mesh in a layout, the mesh's own when they need no packing. */
+const void *vertex_data(const Mesh &mesh,
+                        const VertexLayout &layout,
+                        const glm::vec3 &min,
+                        const glm::vec3 &max,
+                        std::vector<unsigned char> &packed) {
+  if (layout == VertexLayout()) {
+    return mesh.vertices.data();
+  }
+  packed.resize(mesh.vertices.size() * layout.stride());
+  layout.pack(mesh.vertices.data(), mesh.vertices.size(), min, max, packed.data());
+  return packed.data();
+}
+
+/** Vertex array of a mesh, vertex arrays are not shared between contexts. */
+GLuint create_vertex_array(const GLuint array_buffer, const GLuint element_array_buffer, const VertexLayout &layout) {
+  GLuint vertex_array;
+  glGenVertexArrays(1, &vertex_array);
+  glBindVertexArray(vertex_array);
+  glBindBuffer(GL_ARRAY_BUFFER, array_buffer);
+  // Position, normal, tangent, uv and weight.
+  const auto attributes = layout.attributes();
+  for (size_t i = 0; i < attributes.size(); i++) {
+    const auto &attribute = attributes[i];
+    GLenum type = GL_FLOAT;
+    GLboolean normalized = GL_FALSE;
+    switch (attribute.type) {
+      case VertexLayout::Type::FLOAT: type = GL_FLOAT; break;
+      case VertexLayout::Type::HALF: type = GL_HALF_FLOAT; break;
+      case VertexLayout::Type::UNORM16: type = GL_UNSIGNED_SHORT; normalized = GL_TRUE; break;
+      case VertexLayout::Type::SNORM16: type = GL_SHORT; normalized = GL_TRUE; break;
+    }
+    glVertexAttribPointer(GLuint(i), attribute.components, type, normalized, GLsizei(layout.stride()),
+                          reinterpret_cast<const void *>(attribute.offset));
+    glEnableVertexAttribArray(GLuint(i));
+  }
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, element_array_buffer);
+  glBindVertexArray(0);
+  return vertex_array;
+}
+
 void APIENTRY
 message_callback(GLenum source,
                  GLenum type,
@@ -56,11 +206,15 @@ message_callback(GLenum source,
 }
 
 Renderer::Renderer(const glm::vec4 &color, const glm::ivec2 &resolution) :
+    bloom_strength(0.1f),
+    bloom_radius(1.0f),
+    resolution_scale_(1.0f),
+    resolution_sample_(0),
+    frame_(0),
     cube_camera_index_({0, 0}),
     standard_target_(resolution),
     multi_target_(resolution),
-    blur_target0_(resolution / 4),
-    blur_target1_(resolution / 4),
+    bloom_target_(resolution),
     shadow_maps_render_buffer_(256),
     shadow_maps_{ShadowMapTarget(shadow_maps_render_buffer_),
                  ShadowMapTarget(shadow_maps_render_buffer_)},
@@ -73,7 +227,8 @@ Renderer::Renderer(const glm::vec4 &color, const glm::ivec2 &resolution) :
     white_texture_(GL_RGBA, GL_RGBA, 1, 1, GL_REPEAT, std::array<unsigned char, 4>{255, 255, 255, 255}.data(), true),
     brdf_lut_texture_(Texture2D("assets/brdfLUT.png", false, false, Texture2D::Wrap::CLAMP)) {
 
-  if (!gladLoadGL()) {
+  // A context created elsewhere, like io::HeadlessContext, may already have loaded GL.
+  if (!GLVersion.major && !gladLoadGL()) {
     printf("No valid OpenGL context.\n");
     exit(-1);
   }
@@ -97,25 +252,27 @@ Renderer::Renderer(const glm::vec4 &color, const glm::ivec2 &resolution) :
 }
 
 Renderer::~Renderer() {
-  for (auto &fb : frame_buffers_) {
-    glDeleteFramebuffers(1, &fb.second);
-  }
+  upload_queue_.reset();
 
-  for (auto &rb : render_buffers) {
-    glDeleteRenderbuffers(1, &rb.second);
-  }
+  frame_buffers_.for_each([](unsigned int, GLuint &frame_buffer) {
+    glDeleteFramebuffers(1, &frame_buffer);
+  });
 
-  for (auto &ab : array_buffers_) {
-    glDeleteBuffers(1, &ab.second.id);
-  }
+  render_buffers.for_each([](unsigned int, GLuint &render_buffer) {
+    glDeleteRenderbuffers(1, &render_buffer);
+  });
 
-  for (auto &eab : element_array_buffers_) {
-    glDeleteBuffers(1, &eab.second.id);
-  }
+  array_buffers_.for_each([](unsigned int, Buffer &buffer) {
+    glDeleteBuffers(1, &buffer.id);
+  });
 
-  for (auto &va : vertex_arrays_) {
-    glDeleteVertexArrays(1, &va.second);
-  }
+  element_array_buffers_.for_each([](unsigned int, Buffer &buffer) {
+    glDeleteBuffers(1, &buffer.id);
+  });
+
+  vertex_arrays_.for_each([](unsigned int, GLuint &vertex_array) {
+    glDeleteVertexArrays(1, &vertex_array);
+  });
 }
 
 void Renderer::load(const Model &model) {
@@ -145,60 +302,469 @@ void Renderer::unload(const Model &model) {
 }
 
 void Renderer::load_or_update(const Texture2D &texture) {
-  if (textures_.find(texture.id()) == textures_.end()) {
-    textures_.insert({texture.id(), std::make_unique<TextureBuffer2D>(texture)});
+  if (!textures_.contains(texture.id())) {
+    textures_.insert(texture.id(), std::make_unique<TextureBuffer2D>(texture));
+    textures_.at(texture.id())->usage.frame = frame_;
   } else {
     auto &buffer = textures_.at(texture.id());
+    buffer->usage.frame = frame_;
     if (texture.layers.modified() > buffer->modified) {
       glBindTexture(GL_TEXTURE_2D, buffer->texture);
-      glTexImage2D(GL_TEXTURE_2D, 0,
-                   format_convert(texture.format).internal_format,
-                   texture.width(), texture.height(), 0,
-                   format_convert(texture.format).format,
-                   GL_UNSIGNED_BYTE, texture.layers[0].data());
-      if (texture.mipmaps) {
-        glGenerateMipmap(GL_TEXTURE_2D);
-      }
+      upload_texture_2d(texture);
       glBindTexture(GL_TEXTURE_2D, 0);
       buffer->modified = texture.layers.modified();
+      buffer->base_level = 0;
+      buffer->bytes = buffer->resident_size(texture.mipmaps);
     }
   }
 }
 
+int Renderer::initial_level(const Texture2D &texture) const {
+  int base_level = texture.levels - 1;
+  while (base_level > 0
+      && texture.width(base_level - 1) <= texture_streaming.initial_size
+      && texture.height(base_level - 1) <= texture_streaming.initial_size) {
+    base_level--;
+  }
+  return base_level;
+}
+
 void Renderer::load(const SharedTexture2D &texture) {
   if (texture) {
-    load_or_update(*texture);
+    // Streamed textures start with only their smallest levels.
+    const bool streamed = texture_streaming.enabled && texture->levels > 1;
+    if (upload_queue_ && !textures_.contains(texture->id())) {
+      if (pending_textures_.insert(texture->id()).second) {
+        Upload upload;
+        upload.texture = texture;
+        upload.modified = texture->layers.modified();
+        upload.base_level = streamed ? initial_level(*texture) : 0;
+        upload.streamed = streamed;
+        upload_queue_->push(std::move(upload));
+      }
+    } else if (streamed && !textures_.contains(texture->id())) {
+      auto buffer = std::make_unique<TextureBuffer2D>(*texture, initial_level(*texture));
+      buffer->source = texture;
+      textures_.insert(texture->id(), std::move(buffer));
+    } else {
+      load_or_update(*texture);
+    }
+    if (auto *buffer = textures_.find(texture->id())) {
+      auto &usage = (*buffer)->usage;
+      usage.frame = frame_;
+      // Only once, copying the owner costs atomic reference counting.
+      if (!usage.shared) {
+        usage.owner = texture;
+        usage.shared = true;
+      }
+    }
   }
 }
 
 void Renderer::unload(const SharedTexture2D &texture) {
   if (texture) {
-    if (textures_.find(texture->id()) != textures_.end()) {
-      auto gl_id = textures_.at(texture->id())->texture;
-      glDeleteTextures(1, &gl_id);
-      textures_.erase(texture->id());
+    // The buffer deletes its GL texture.
+    pending_textures_.erase(texture->id());
+    textures_.erase(texture->id());
+  }
+}
+
+void Renderer::upload_async(const std::function<void(bool)> &make_current) {
+  upload_queue_ = std::make_unique<UploadQueue>(make_current);
+}
+
+void Renderer::finish_uploads() {
+  if (!upload_queue_) {
+    return;
+  }
+  MOS_PROFILE_ZONE("gfx::Renderer::finish_uploads");
+  std::vector<Upload> uploads;
+  try {
+    uploads = upload_queue_->poll();
+  } catch (...) {
+    // The worker is gone, load what is still pending while rendering.
+    upload_queue_.reset();
+    pending_meshes_.clear();
+    pending_textures_.clear();
+    throw;
+  }
+  for (auto &upload : uploads) {
+    if (upload.mesh) {
+      const auto id = upload.mesh->id();
+      if (pending_meshes_.erase(id) == 0) {
+        upload.release();
+        continue;
+      }
+      array_buffers_.insert(id, Buffer{upload.array_buffer, upload.modified,
+                                       upload.mesh->vertices.size() * upload.layout.stride()});
+      element_array_buffers_.insert(id, Buffer{upload.element_array_buffer, upload.triangles_modified,
+                                               upload.mesh->triangles.size() * 3 * sizeof(unsigned int)});
+      vertex_arrays_.insert(id, create_vertex_array(upload.array_buffer, upload.element_array_buffer, upload.layout));
+      vertex_layouts_.insert_or_assign(id, upload.layout);
+      mesh_bounds_.insert_or_assign(id, MeshBounds(*upload.mesh));
+    } else {
+      const auto id = upload.texture->id();
+      if (pending_textures_.erase(id) == 0) {
+        upload.release();
+        continue;
+      }
+      auto buffer = std::make_unique<TextureBuffer2D>(*upload.texture, upload.texture_buffer, upload.base_level);
+      buffer->modified = upload.modified;
+      if (upload.streamed) {
+        buffer->source = upload.texture;
+      }
+      buffer->usage.frame = frame_;
+      buffer->usage.owner = upload.texture;
+      buffer->usage.shared = true;
+      textures_.insert(id, std::move(buffer));
     }
   }
 }
 
-void Renderer::clear_buffers() {
-  textures_.clear();
+bool Renderer::resident(const SharedMesh &mesh) const {
+  return mesh && vertex_arrays_.contains(mesh->id());
+}
+
+GLuint Renderer::texture_or(const SharedTexture2D &texture, const TextureBuffer2D &placeholder) const {
+  if (texture) {
+    if (const auto *buffer = textures_.find(texture->id())) {
+      return (*buffer)->texture;
+    }
+  }
+  return placeholder.texture;
+}
+
+float Renderer::resolution_scale() const { return resolution_scale_; }
+
+size_t Renderer::Memory::total() const {
+  return textures + vertex_buffers + index_buffers;
+}
+
+Renderer::Memory Renderer::memory() const {
+  Memory memory;
+  memory.textures = texture_memory();
+  array_buffers_.for_each([&](unsigned int, const Buffer &buffer) {
+    memory.vertex_buffers += buffer.bytes;
+  });
+  element_array_buffers_.for_each([&](unsigned int, const Buffer &buffer) {
+    memory.index_buffers += buffer.bytes;
+  });
+  return memory;
+}
+
+size_t Renderer::texture_memory() const {
+  size_t memory = 0;
+  textures_.for_each([&](unsigned int, const std::unique_ptr<TextureBuffer2D> &texture) {
+    memory += texture->bytes;
+  });
+  return memory;
+}
+
+void Renderer::request_texture_levels(const Model &model,
+                                      const glm::mat4 &transform,
+                                      const Camera &camera,
+                                      const glm::vec2 &resolution) {
+  const auto &bounds = mesh_bounds_.at(model.mesh->id());
+  const auto center = glm::vec3(transform * glm::vec4((bounds.min + bounds.max) / 2.0f, 1.0f));
+  const float scale = glm::max(glm::length(glm::vec3(transform[0])),
+                               glm::max(glm::length(glm::vec3(transform[1])), glm::length(glm::vec3(transform[2]))));
+  const float radius = glm::length(bounds.max - bounds.min) / 2.0f * scale;
+  const float distance = glm::distance(camera.position(), center);
+  // Projected diameter in pixels, assuming the texture spans the model once.
+  const float pixels = distance > radius
+                       ? glm::max(radius * camera.projection[1][1] / distance * resolution.y, 1.0f)
+                       : resolution.y;
+
+  for (const auto &map : {model.material.albedo_map, model.material.emission_map, model.material.normal_map,
+                          model.material.metallic_map, model.material.roughness_map,
+                          model.material.ambient_occlusion_map}) {
+    if (map) {
+      auto *buffer = textures_.find(map->id());
+      if (buffer && !(*buffer)->source.expired()) {
+        const float texels = float(glm::max(map->width(), map->height()));
+        const int level = int(glm::max(std::floor(std::log2(texels / pixels)), 0.0f));
+        (*buffer)->request(glm::min(level, map->levels - 1));
+      }
+    }
+  }
+}
 
-  for (auto &ab : array_buffers_) {
-    glDeleteBuffers(1, &ab.second.id);
+bool Renderer::evict_textures(const size_t needed, size_t &memory, const TextureBuffer2D *keep) {
+  if (memory + needed <= texture_streaming.budget) {
+    return true;
   }
-  array_buffers_.clear();
+  // Levels nobody asked for first, then least recently used.
+  FrameVector<TextureBuffer2D *> candidates{FrameAllocator<TextureBuffer2D *>(frame_arena_)};
+  textures_.for_each([&](unsigned int, std::unique_ptr<TextureBuffer2D> &texture) {
+    auto *buffer = texture.get();
+    if (buffer != keep && !buffer->source.expired() && buffer->base_level < buffer->levels - 1
+        && (buffer->usage.frame < frame_ || buffer->base_level < buffer->wanted_level)) {
+      candidates.push_back(buffer);
+    }
+  });
+  std::sort(candidates.begin(), candidates.end(), [](const TextureBuffer2D *a, const TextureBuffer2D *b) {
+    const bool a_over = a->base_level < a->wanted_level;
+    const bool b_over = b->base_level < b->wanted_level;
+    if (a_over != b_over) {
+      return a_over;
+    }
+    return a->usage.frame < b->usage.frame;
+  });
+  for (auto *buffer : candidates) {
+    while (memory + needed > texture_streaming.budget && buffer->base_level < buffer->levels - 1
+        && (buffer->usage.frame < frame_ || buffer->base_level < buffer->wanted_level)) {
+      memory -= buffer->level_size(buffer->base_level);
+      buffer->stream_out();
+    }
+    if (memory + needed <= texture_streaming.budget) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void Renderer::stream_textures() {
+  MOS_PROFILE_ZONE("gfx::Renderer::stream_textures");
+  if (!texture_streaming.enabled) {
+    return;
+  }
+  size_t memory = texture_memory();
+
+  FrameVector<TextureBuffer2D *> wanted{FrameAllocator<TextureBuffer2D *>(frame_arena_)};
+  textures_.for_each([&](unsigned int, std::unique_ptr<TextureBuffer2D> &texture) {
+    auto *buffer = texture.get();
+    buffer->requested = false;
+    if (buffer->source.expired()) {
+      return;
+    }
+    if (frame_ - buffer->usage.frame > texture_streaming.unused_frames) {
+      buffer->wanted_level = buffer->levels - 1;
+    }
+    if (buffer->wanted_level < buffer->base_level) {
+      wanted.push_back(buffer);
+    }
+  });
+  // Largest difference first, so blurry textures catch up before sharp ones refine.
+  std::sort(wanted.begin(), wanted.end(), [](const TextureBuffer2D *a, const TextureBuffer2D *b) {
+    const int a_missing = a->base_level - a->wanted_level;
+    const int b_missing = b->base_level - b->wanted_level;
+    if (a_missing != b_missing) {
+      return a_missing > b_missing;
+    }
+    return a->usage.frame > b->usage.frame;
+  });
+
+  size_t uploaded = 0;
+  for (auto *buffer : wanted) {
+    while (buffer->wanted_level < buffer->base_level && uploaded < texture_streaming.upload_budget) {
+      const auto bytes = buffer->level_size(buffer->base_level - 1);
+      if (!evict_textures(bytes, memory, buffer)) {
+        break;
+      }
+      auto source = buffer->source.lock();
+      buffer->stream_in(*source);
+      memory += bytes;
+      uploaded += bytes;
+    }
+  }
+  evict_textures(0, memory, nullptr);
+}
+
+Renderer::Usage &Renderer::use_buffers(const unsigned int id) {
+  auto &usage = *buffer_usage_.get(buffer_usage_.insert(id, Usage()));
+  usage.frame = frame_;
+  return usage;
+}
+
+void Renderer::unload_buffers(const unsigned int id) {
+  pending_meshes_.erase(id);
+  buffer_usage_.erase(id);
+  mesh_bounds_.erase(id);
+  vertex_layouts_.erase(id);
+  if (const auto *vertex_array = vertex_arrays_.find(id)) {
+    glDeleteVertexArrays(1, vertex_array);
+    vertex_arrays_.erase(id);
+  }
+  if (const auto *buffer = array_buffers_.find(id)) {
+    glDeleteBuffers(1, &buffer->id);
+    array_buffers_.erase(id);
+  }
+  if (const auto *buffer = element_array_buffers_.find(id)) {
+    glDeleteBuffers(1, &buffer->id);
+    element_array_buffers_.erase(id);
+  }
+}
+
+void Renderer::release_unused() {
+  MOS_PROFILE_ZONE("gfx::Renderer::release_unused");
+  struct Candidate {
+    unsigned int id;
+    bool texture;
+    bool expired;
+    uint64_t frame;
+    size_t bytes;
+  };
+  auto expired = [&](const Usage &usage) {
+    return (usage.shared && usage.owner.expired())
+        || (residency.unused_frames > 0 && frame_ - usage.frame > residency.unused_frames);
+  };
+  auto release = [&](const Candidate &candidate) {
+    if (candidate.texture) {
+      textures_.erase(candidate.id);
+    } else {
+      unload_buffers(candidate.id);
+    }
+  };
+
+  // Ids are collected first, releasing changes the registries.
+  FrameVector<Candidate> candidates{FrameAllocator<Candidate>(frame_arena_)};
+  size_t memory = 0;
+  textures_.for_each([&](const unsigned int id, const std::unique_ptr<TextureBuffer2D> &texture) {
+    memory += texture->bytes;
+    if (!texture->usage.pinned) {
+      candidates.push_back(Candidate{id, true, expired(texture->usage), texture->usage.frame, texture->bytes});
+    }
+  });
+  buffer_usage_.for_each([&](const unsigned int id, const Usage &usage) {
+    const auto *vertices = array_buffers_.find(id);
+    const auto *triangles = element_array_buffers_.find(id);
+    const size_t bytes = (vertices ? vertices->bytes : 0) + (triangles ? triangles->bytes : 0);
+    memory += bytes;
+    candidates.push_back(Candidate{id, false, expired(usage), usage.frame, bytes});
+  });
+
+  // Expired first, then least recently used until within budget.
+  std::sort(candidates.begin(), candidates.end(), [](const Candidate &a, const Candidate &b) {
+    if (a.expired != b.expired) {
+      return a.expired;
+    }
+    return a.frame < b.frame;
+  });
+  for (const auto &candidate : candidates) {
+    const bool over = memory > residency.budget && candidate.frame < frame_;
+    if (!candidate.expired && !over) {
+      break;
+    }
+    release(candidate);
+    memory -= candidate.bytes;
+  }
+}
 
-  for (auto &eab : element_array_buffers_) {
-    glDeleteBuffers(1, &eab.second.id);
+void Renderer::update_resolution_scale() {
+  if (!dynamic_resolution.enabled || !gpu_profiler_.enabled) {
+    resolution_scale_ = 1.0f;
+    return;
   }
+  // Each resolved frame is one sample, in between there is nothing new.
+  if (gpu_profiler_.resolved_frames() == resolution_sample_) {
+    return;
+  }
+  resolution_sample_ = gpu_profiler_.resolved_frames();
+  const auto milliseconds = float(gpu_profiler_.frame_milliseconds());
+  if (milliseconds <= 0.0f) {
+    return;
+  }
+  // GPU time follows pixel count, which is the square of the scale.
+  const float wanted = resolution_scale_ * std::sqrt(dynamic_resolution.target_milliseconds / milliseconds);
+  resolution_scale_ = glm::clamp(glm::mix(resolution_scale_, wanted, 0.1f),
+                                 dynamic_resolution.min_scale, 1.0f);
+}
+
+GpuProfiler &Renderer::gpu_profiler() { return gpu_profiler_; }
+
+const GpuProfiler &Renderer::gpu_profiler() const { return gpu_profiler_; }
+
+void Renderer::clear_buffers() {
+  // Uploads in flight are released when they finish.
+  pending_meshes_.clear();
+  pending_textures_.clear();
+  textures_.clear();
+  buffer_usage_.clear();
+  mesh_bounds_.clear();
+  vertex_layouts_.clear();
+
+  vertex_arrays_.for_each([](unsigned int, GLuint &vertex_array) {
+    glDeleteVertexArrays(1, &vertex_array);
+  });
+  vertex_arrays_.clear();
+
+  array_buffers_.for_each([](unsigned int, Buffer &buffer) {
+    glDeleteBuffers(1, &buffer.id);
+  });
+  array_buffers_.clear();
+
+  element_array_buffers_.for_each([](unsigned int, Buffer &buffer) {
+    glDeleteBuffers(1, &buffer.id);
+  });
   element_array_buffers_.clear();
 }
 
 void Renderer::render_scene(const Camera &camera,
-                            const Scene &scene,
-                            const glm::ivec2 &resolution) {
+                            const SceneView &scene,
+                            const DrawCommands &commands,
+                            const glm::ivec2 &resolution,
+                            Overdraw *overdraw,
+                            Occlusion *occlusion) {
+  MOS_PROFILE_ZONE("gfx::Renderer::render_scene");
   glViewport(0, 0, resolution.x, resolution.y);
+
+  const bool measure = overdraw && scene.depth_prepass == Scene::DepthPrepass::AUTO;
+  const bool prepass = scene.depth_prepass == Scene::DepthPrepass::ON || (measure && overdraw->prepass);
+  Occlusion *culling = scene.occlusion_culling ? occlusion : nullptr;
+
+  const auto render_depth = [&](const Occlusion::Phase phase) {
+    if (culling) {
+      culling->phase = phase;
+      culling->next = 0;
+    }
+    glUseProgram(depth_program_.program);
+    for (const auto &command : commands) {
+      render_model_depth(command, depth_program_, true, culling);
+    }
+  };
+
+  const auto render_color = [&](const Occlusion::Phase phase) {
+    if (culling) {
+      culling->phase = phase;
+      culling->next = 0;
+    }
+    glUseProgram(standard_program_.program);
+    for (const auto &command : commands) {
+      render_model(command, camera, resolution, standard_program_, prepass, culling);
+    }
+  };
+
+  // Disocclusions since last frame are found against the depth drawn so far.
+  const auto cull_second_phase = [&]() {
+    build_depth_pyramid(*culling, resolution);
+    cull(*culling, camera, 1);
+  };
+
+  if (culling) {
+    culling->bounds.clear();
+    culling->commands.clear();
+    gather_draws(commands, *culling);
+    cull(*culling, camera, 0);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, culling->command_buffer);
+  }
+
+  // Overdraw is measured where opaque geometry is rasterized with LEQUAL.
+  if (measure) {
+    overdraw->begin();
+  }
+  if (prepass) {
+    glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+    render_depth(Occlusion::Phase::FIRST);
+    if (culling) {
+      cull_second_phase();
+      render_depth(Occlusion::Phase::SECOND);
+    }
+    glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+    if (measure) {
+      overdraw->end(resolution, StandardTarget::samples);
+    }
+  }
+
   glUseProgram(standard_program_.program);
   glUniform1i(standard_program_.brdf_lut, 0);
   glUniform1i(standard_program_.shadow_maps[0], 1);
@@ -265,18 +831,94 @@ void Renderer::render_scene(const Camera &camera,
   glUniform1fv(standard_program_.fog_attenuation_factor, 1,
                &scene.fog.attenuation_factor);
 
-  for (auto &model : scene.models) {
-    render_model(model, glm::mat4(1.0f), camera,
-                 scene.lights,
-                 scene.environment_lights,
-                 scene.fog,
-                 resolution, standard_program_);
+  if (prepass) {
+    render_color(Occlusion::Phase::BOTH);
+  } else {
+    render_color(Occlusion::Phase::FIRST);
+    if (culling) {
+      cull_second_phase();
+      render_color(Occlusion::Phase::SECOND);
+    }
+  }
+  glDepthFunc(GL_LEQUAL);
+  if (culling) {
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+  }
+  if (measure && !prepass) {
+    overdraw->end(resolution, StandardTarget::samples);
   }
   render_boxes(scene.boxes, camera);
   render_particles(scene.particle_clouds, camera, resolution);
+  render_texts(scene.texts, camera);
+}
+
+void Renderer::render_texts(Span<const Text> texts, const Camera &camera) {
+  if (texts.size() == 0) {
+    return;
+  }
+  MOS_PROFILE_ZONE("gfx::Renderer::render_texts");
+  auto &batch = text_batch_;
+  batch.vertices.clear();
+  batch.ranges.clear();
+
+  const auto append = [&](const Text &text) {
+    const auto &model = text.model();
+    const Mesh &mesh = *model.mesh;
+    const auto color = text.color();
+    for (const auto &vertex : mesh.vertices) {
+      batch.vertices.push_back(TextBatch::GlyphVertex{glm::vec3(model.transform * glm::vec4(vertex.position, 1.0f)),
+                                                      vertex.uv, color});
+    }
+  };
+
+  // Group quads by atlas, in order of first use.
+  for (const auto &text : texts) {
+    const auto &atlas = text.font().texture;
+    if (std::any_of(batch.ranges.begin(), batch.ranges.end(),
+                    [&](const TextBatch::Range &range) { return range.atlas == atlas; })) {
+      continue;
+    }
+    TextBatch::Range range{atlas, text.font().distance_field, batch.vertices.size() / 4, 0};
+    for (const auto &other : texts) {
+      if (other.font().texture == atlas) {
+        append(other);
+      }
+    }
+    range.count = batch.vertices.size() / 4 - range.first;
+    batch.ranges.push_back(range);
+  }
+  if (batch.vertices.empty()) {
+    return;
+  }
+
+  batch.reserve(batch.vertices.size() / 4);
+  glBindBuffer(GL_ARRAY_BUFFER, batch.buffer);
+  const auto size = GLsizeiptr(batch.vertices.size() * sizeof(TextBatch::GlyphVertex));
+  // Orphan the storage of the previous draw.
+  glBufferData(GL_ARRAY_BUFFER, size, nullptr, GL_STREAM_DRAW);
+  glBufferSubData(GL_ARRAY_BUFFER, 0, size, batch.vertices.data());
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+  glUseProgram(text_program_.program);
+  const glm::mat4 view_projection = camera.projection * camera.view;
+  glUniformMatrix4fv(text_program_.view_projection, 1, GL_FALSE, &view_projection[0][0]);
+  glUniform1i(text_program_.atlas, 0);
+  glDepthMask(GL_FALSE);
+  for (const auto &range : batch.ranges) {
+    load(range.atlas);
+    glBindVertexArray(batch.vertex_array);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, texture_or(range.atlas, black_texture_));
+    glUniform1i(text_program_.distance_field, range.distance_field);
+    glDrawElements(GL_TRIANGLES, GLsizei(range.count * 6), GL_UNSIGNED_INT,
+                   reinterpret_cast<const void *>(range.first * 6 * sizeof(GLuint)));
+    gpu_profiler_.draw(range.count * 2);
+  }
+  glDepthMask(GL_TRUE);
+  glBindVertexArray(0);
 }
 
-void Renderer::render_boxes(const Boxes &boxes, const mos::gfx::Camera &camera) {
+void Renderer::render_boxes(Span<const gfx::Box> boxes, const mos::gfx::Camera &camera) {
 
   glUseProgram(box_program_.program);
   glBindVertexArray(box.vertex_array);
@@ -295,26 +937,30 @@ void Renderer::render_boxes(const Boxes &boxes, const mos::gfx::Camera &camera)
                    (GLvoid *) (4 * sizeof(GLuint)));
     glDrawElements(GL_LINES, 8, GL_UNSIGNED_INT,
                    (GLvoid *) (8 * sizeof(GLuint)));
+    gpu_profiler_.draw();
+    gpu_profiler_.draw();
+    gpu_profiler_.draw();
   }
   glBindVertexArray(0);
 }
 
-void Renderer::render_particles(const ParticleClouds &clouds,
+void Renderer::render_particles(Span<const ParticleCloud> clouds,
                                 const mos::gfx::Camera &camera,
                                 const glm::vec2 &resolution) {
   for (auto &particles : clouds) {
-    if (vertex_arrays_.find(particles.id()) == vertex_arrays_.end()) {
+    use_buffers(particles.id());
+    if (!vertex_arrays_.contains(particles.id())) {
       unsigned int vertex_array;
       glGenVertexArrays(1, &vertex_array);
       glBindVertexArray(vertex_array);
-      if (array_buffers_.find(particles.id()) == array_buffers_.end()) {
+      if (!array_buffers_.contains(particles.id())) {
         unsigned int array_buffer;
         glGenBuffers(1, &array_buffer);
         glBindBuffer(GL_ARRAY_BUFFER, array_buffer);
         glBufferData(GL_ARRAY_BUFFER, particles.particles.size() * sizeof(Particle),
                      particles.particles.data(), GL_STREAM_DRAW);
         glBindBuffer(GL_ARRAY_BUFFER, 0);
-        array_buffers_.insert({particles.id(), Buffer{array_buffer, particles.particles.modified()}});
+        array_buffers_.insert(particles.id(), Buffer{array_buffer, particles.particles.modified(), 0});
       }
       glBindBuffer(GL_ARRAY_BUFFER, array_buffers_.at(particles.id()).id);
       glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Particle), 0);
@@ -332,11 +978,12 @@ void Renderer::render_particles(const ParticleClouds &clouds,
       glEnableVertexAttribArray(2);
       glEnableVertexAttribArray(3);
       glBindVertexArray(0);
-      vertex_arrays_.insert({particles.id(), vertex_array});
+      vertex_arrays_.insert(particles.id(), vertex_array);
     }
-    glBindBuffer(GL_ARRAY_BUFFER, array_buffers_.at(particles.id()).id);
-    glBufferData(GL_ARRAY_BUFFER, particles.particles.size() * sizeof(Particle),
-                 particles.particles.data(), GL_STREAM_DRAW);
+    auto &array_buffer = array_buffers_.at(particles.id());
+    array_buffer.bytes = particles.particles.size() * sizeof(Particle);
+    glBindBuffer(GL_ARRAY_BUFFER, array_buffer.id);
+    glBufferData(GL_ARRAY_BUFFER, array_buffer.bytes, particles.particles.data(), GL_STREAM_DRAW);
     glBindBuffer(GL_ARRAY_BUFFER, 0);
 
     glm::mat4 mv = camera.view;
@@ -348,9 +995,7 @@ void Renderer::render_particles(const ParticleClouds &clouds,
 
     load(particles.emission_map);
     glActiveTexture(GL_TEXTURE10);
-    glBindTexture(GL_TEXTURE_2D, particles.emission_map
-                                 ? textures_.at(particles.emission_map->id())->texture
-                                 : black_texture_.texture);
+    glBindTexture(GL_TEXTURE_2D, texture_or(particles.emission_map, black_texture_));
     glUniform1i(particle_program_.texture, 10);
 
     glUniformMatrix4fv(particle_program_.mvp, 1, GL_FALSE, &mvp[0][0]);
@@ -360,177 +1005,121 @@ void Renderer::render_particles(const ParticleClouds &clouds,
 
     glBlendFunc(GL_SRC_ALPHA, GL_ONE);
     glDrawArrays(GL_POINTS, 0, particles.particles.size());
+    gpu_profiler_.draw();
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
   }
 }
 
-void Renderer::render_model(const Model &model,
-                            const glm::mat4 &parent_transform,
-                            const Camera &camera,
-                            const Lights &lights,
-                            const EnvironmentLights &environment_lights,
-                            const Fog &fog,
-                            const glm::vec2 &resolution,
+void Renderer::render_model(const DrawCommand &command,
                             const EnvironmentProgram &program) {
+  MOS_PROFILE_ZONE("gfx::Renderer::render_model");
 
-  const glm::mat4 mvp = camera.projection * camera.view * parent_transform * model.transform;
-
-  if (model.mesh) {
-    glBindVertexArray(vertex_arrays_.at(model.mesh->id()));
+  if (command.vertex_array) {
+    const auto &node = *command.node;
+    const auto &material = node.model->material;
+    glBindVertexArray(command.vertex_array);
 
     const auto &uniforms = program;
 
     glActiveTexture(GL_TEXTURE3);
-    glBindTexture(GL_TEXTURE_2D, model.material.albedo_map
-                                 ? textures_.at(model.material.albedo_map->id())->texture
-                                 : black_texture_.texture);
+    glBindTexture(GL_TEXTURE_2D, command.textures[0]);
 
     glActiveTexture(GL_TEXTURE4);
-    glBindTexture(GL_TEXTURE_2D, model.material.emission_map
-                                 ? textures_.at(model.material.emission_map->id())->texture
-                                 : black_texture_.texture);
+    glBindTexture(GL_TEXTURE_2D, command.textures[1]);
 
-    static const glm::mat4 bias(0.5, 0.0, 0.0, 0.0, 0.0, 0.5, 0.0, 0.0, 0.0, 0.0,
-                                0.5, 0.0, 0.5, 0.5, 0.5, 1.0);
-
-    for (size_t i = 0; i < lights.size(); i++) {
-      const glm::mat4 depth_bias_mvp = bias * lights[i].camera.projection *
-          lights[i].camera.view * parent_transform *
-          model.transform;
+    for (size_t i = 0; i < command.depth_bias_mvps.size(); i++) {
       glUniformMatrix4fv(uniforms.depth_bias_mvps[i], 1, GL_FALSE,
-                         &depth_bias_mvp[0][0]);
+                         &command.depth_bias_mvps[i][0][0]);
     }
 
     glUniformMatrix4fv(uniforms.model_view_projection_matrix, 1, GL_FALSE,
-                       &mvp[0][0]);
-    auto model_matrix = parent_transform * model.transform;
-    glUniformMatrix4fv(uniforms.model_matrix, 1, GL_FALSE, &model_matrix[0][0]);
-
-    glm::mat3 normal_matrix = glm::inverseTranspose(glm::mat3(parent_transform) *
-        glm::mat3(model.transform));
-    normal_matrix =
-        glm::inverseTranspose(glm::mat3(parent_transform * model.transform));
-    glUniformMatrix3fv(uniforms.normal_matrix, 1, GL_FALSE, &normal_matrix[0][0]);
-
-    glm::vec4 albedo =
-        glm::vec4(model.material.albedo, model.material.albedo_map || model.material.emission_map ? 0.0f : 1.0f);
+                       &command.model_view_projection[0][0]);
+    glUniformMatrix4fv(uniforms.model_matrix, 1, GL_FALSE, &node.world[0][0]);
+    glUniformMatrix3fv(uniforms.normal_matrix, 1, GL_FALSE, &node.normal[0][0]);
+    glUniform3fv(uniforms.position_offset, 1, glm::value_ptr(command.position_offset));
+    glUniform3fv(uniforms.position_scale, 1, glm::value_ptr(command.position_scale));
+    glUniform1i(uniforms.octahedral, command.octahedral);
+
     glUniform4fv(uniforms.material_albedo, 1,
-                 glm::value_ptr(albedo));
-    glm::vec4 emission =
-        glm::vec4(model.material.emission, model.material.emission_map || model.material.albedo_map ? 0.0f : 1.0f);
+                 glm::value_ptr(command.albedo));
     glUniform4fv(uniforms.material_emission, 1,
-                 glm::value_ptr(emission));
+                 glm::value_ptr(command.emission));
     glUniform1fv(uniforms.material_roughness, 1,
-                 &model.material.roughness);
+                 &material.roughness);
     glUniform1fv(uniforms.material_metallic, 1,
-                 &model.material.metallic);
-    glUniform1fv(uniforms.material_opacity, 1, &model.material.opacity);
+                 &material.metallic);
+    glUniform1fv(uniforms.material_opacity, 1, &material.opacity);
 
-    glUniform1fv(uniforms.material_emission_strength, 1, &model.material.emission_strength);
-    glUniform1fv(uniforms.material_ambient_occlusion, 1, &model.material.ambient_occlusion);
-    glUniform3fv(uniforms.material_factor, 1, glm::value_ptr(model.material.factor));
+    glUniform1fv(uniforms.material_emission_strength, 1, &material.emission_strength);
+    glUniform1fv(uniforms.material_ambient_occlusion, 1, &material.ambient_occlusion);
+    glUniform3fv(uniforms.material_factor, 1, glm::value_ptr(material.factor));
 
-    glDrawElements(GL_TRIANGLES, model.mesh->triangles.size() * 3, GL_UNSIGNED_INT, 0);
-  }
-
-  for (const auto &child : model.models) {
-    render_model(child, parent_transform * model.transform, camera, lights,
-                 environment_lights, fog, resolution, program);
+    glDrawElements(GL_TRIANGLES, command.count, GL_UNSIGNED_INT, 0);
+    gpu_profiler_.draw(command.count / 3);
   }
 }
 
-void Renderer::render_model(const Model &model,
-                            const glm::mat4 &parent_transform,
+void Renderer::render_model(const DrawCommand &command,
                             const Camera &camera,
-                            const Lights &lights,
-                            const EnvironmentLights &environment_lights,
-                            const Fog &fog,
                             const glm::vec2 &resolution,
-                            const StandardProgram &program) {
-
-  const glm::mat4 mvp = camera.projection * camera.view * parent_transform * model.transform;
+                            const StandardProgram &program,
+                            const bool depth_prepass,
+                            Occlusion *occlusion) {
+  MOS_PROFILE_ZONE("gfx::Renderer::render_model");
 
-  if (model.mesh) {
-    glBindVertexArray(vertex_arrays_.at(model.mesh->id()));
+  if (command.vertex_array) {
+    const auto &node = *command.node;
+    const auto &model = *node.model;
+    const auto &material = model.material;
+    glBindVertexArray(command.vertex_array);
 
     const auto &uniforms = program;
 
-    glActiveTexture(GL_TEXTURE5);
-    glBindTexture(GL_TEXTURE_2D, model.material.albedo_map
-                                 ? textures_.at(model.material.albedo_map->id())->texture
-                                 : black_texture_.texture);
-
-    glActiveTexture(GL_TEXTURE6);
-    glBindTexture(GL_TEXTURE_2D, model.material.emission_map
-                                 ? textures_.at(model.material.emission_map->id())->texture
-                                 : black_texture_.texture);
-
-    glActiveTexture(GL_TEXTURE7);
-    glBindTexture(GL_TEXTURE_2D, model.material.normal_map
-                                 ? textures_.at(model.material.normal_map->id())->texture
-                                 : black_texture_.texture);
-
-    glActiveTexture(GL_TEXTURE8);
-    glBindTexture(GL_TEXTURE_2D, model.material.metallic_map
-                                 ? textures_.at(model.material.metallic_map->id())->texture
-                                 : black_texture_.texture);
-
-    glActiveTexture(GL_TEXTURE9);
-    glBindTexture(GL_TEXTURE_2D, model.material.roughness_map
-                                 ? textures_.at(model.material.roughness_map->id())->texture
-                                 : black_texture_.texture);
-
-    glActiveTexture(GL_TEXTURE10);
-    glBindTexture(GL_TEXTURE_2D, model.material.ambient_occlusion_map
-                                 ? textures_.at(model.material.ambient_occlusion_map->id())->texture
-                                 : white_texture_.texture);
-
-    static const glm::mat4 bias(0.5, 0.0, 0.0, 0.0, 0.0, 0.5, 0.0, 0.0, 0.0, 0.0,
-                                0.5, 0.0, 0.5, 0.5, 0.5, 1.0);
+    for (size_t i = 0; i < command.textures.size(); i++) {
+      glActiveTexture(GL_TEXTURE5 + GLenum(i));
+      glBindTexture(GL_TEXTURE_2D, command.textures[i]);
+    }
 
-    for (size_t i = 0; i < lights.size(); i++) {
-      const glm::mat4 depth_bias_mvp = bias * lights[i].camera.projection *
-          lights[i].camera.view * parent_transform *
-          model.transform;
+    for (size_t i = 0; i < command.depth_bias_mvps.size(); i++) {
       glUniformMatrix4fv(uniforms.depth_bias_mvps[i], 1, GL_FALSE,
-                         &depth_bias_mvp[0][0]);
+                         &command.depth_bias_mvps[i][0][0]);
     }
 
     glUniformMatrix4fv(uniforms.model_view_projection_matrix, 1, GL_FALSE,
-                       &mvp[0][0]);
-    auto model_matrix = parent_transform * model.transform;
-    glUniformMatrix4fv(uniforms.model_matrix, 1, GL_FALSE, &model_matrix[0][0]);
-
-    glm::mat3 normal_matrix = glm::inverseTranspose(glm::mat3(parent_transform) *
-        glm::mat3(model.transform));
-    normal_matrix =
-        glm::inverseTranspose(glm::mat3(parent_transform * model.transform));
-    glUniformMatrix3fv(uniforms.normal_matrix, 1, GL_FALSE, &normal_matrix[0][0]);
-
-    glm::vec4 albedo =
-        glm::vec4(model.material.albedo, model.material.albedo_map || model.material.emission_map ? 0.0f : 1.0f);
+                       &command.model_view_projection[0][0]);
+    glUniformMatrix4fv(uniforms.model_matrix, 1, GL_FALSE, &node.world[0][0]);
+    glUniformMatrix3fv(uniforms.normal_matrix, 1, GL_FALSE, &node.normal[0][0]);
+    glUniform3fv(uniforms.position_offset, 1, glm::value_ptr(command.position_offset));
+    glUniform3fv(uniforms.position_scale, 1, glm::value_ptr(command.position_scale));
+    glUniform1i(uniforms.octahedral, command.octahedral);
+
     glUniform4fv(uniforms.material_albedo, 1,
-                 glm::value_ptr(albedo));
-    glm::vec4 emission =
-        glm::vec4(model.material.emission, model.material.emission_map || model.material.albedo_map ? 0.0f : 1.0f);
+                 glm::value_ptr(command.albedo));
     glUniform4fv(uniforms.material_emission, 1,
-                 glm::value_ptr(emission));
+                 glm::value_ptr(command.emission));
     glUniform1fv(uniforms.material_roughness, 1,
-                 &model.material.roughness);
+                 &material.roughness);
     glUniform1fv(uniforms.material_metallic, 1,
-                 &model.material.metallic);
-    glUniform1fv(uniforms.material_opacity, 1, &model.material.opacity);
+                 &material.metallic);
+    glUniform1fv(uniforms.material_opacity, 1, &material.opacity);
 
-    glUniform1fv(uniforms.material_emission_strength, 1, &model.material.emission_strength);
-    glUniform1fv(uniforms.material_ambient_occlusion, 1, &model.material.ambient_occlusion);
-    glUniform3fv(uniforms.material_factor, 1, glm::value_ptr(model.material.factor));
+    glUniform1fv(uniforms.material_emission_strength, 1, &material.emission_strength);
+    glUniform1fv(uniforms.material_ambient_occlusion, 1, &material.ambient_occlusion);
+    glUniform3fv(uniforms.material_factor, 1, glm::value_ptr(material.factor));
 
-    glDrawElements(GL_TRIANGLES, model.mesh->triangles.size() * 3, GL_UNSIGNED_INT, 0);
-  }
+    if (texture_streaming.enabled) {
+      request_texture_levels(model, node.world, camera, resolution);
+    }
 
-  for (const auto &child : model.models) {
-    render_model(child, parent_transform * model.transform, camera, lights,
-                 environment_lights, fog, resolution, program);
+    // Opaque models already have their depth from the pre-pass.
+    glDepthFunc(depth_prepass && !command.transparent ? GL_EQUAL : GL_LEQUAL);
+
+    if (occlusion) {
+      occlusion->draw_elements();
+    } else {
+      glDrawElements(GL_TRIANGLES, command.count, GL_UNSIGNED_INT, 0);
+    }
+    gpu_profiler_.draw(command.count / 3);
   }
 }
 
@@ -550,7 +1139,8 @@ void Renderer::clear_color(const glm::vec4 &color) {
   glClear(GL_COLOR_BUFFER_BIT);
 }
 
-void Renderer::render_shadow_maps(const Models &models, const Lights &lights) {
+void Renderer::render_shadow_maps(const std::array<DrawCommands, 2> &commands, const Lights &lights) {
+  MOS_PROFILE_ZONE("gfx::Renderer::render_shadow_maps");
   for (size_t i = 0; i < shadow_maps_.size(); i++) {
     if (lights[i].strength > 0.0f) {
       auto frame_buffer = shadow_maps_[i].frame_buffer;
@@ -559,19 +1149,19 @@ void Renderer::render_shadow_maps(const Models &models, const Lights &lights) {
       auto resolution = shadow_maps_render_buffer_.resolution;
       glUseProgram(depth_program_.program);
       glViewport(0, 0, resolution, resolution);
-      for (auto &model : models) {
-        render_model_depth(model, glm::mat4(1.0f), lights[i].camera, glm::vec2(resolution), depth_program_);
+      for (const auto &command : commands[i]) {
+        render_model_depth(command, depth_program_);
       }
       glBindFramebuffer(GL_FRAMEBUFFER, 0);
-      //Generate mipmaps
-      glBindTexture(GL_TEXTURE_2D, shadow_maps_[i].texture);
-      glGenerateMipmap(GL_TEXTURE_2D);
       glBindTexture(GL_TEXTURE_2D, 0);
     }
   }
 }
 
-void Renderer::render_environment(const Scene &scene, const glm::vec4 &clear_color) {
+void Renderer::render_environment(const SceneView &scene,
+                                  const std::array<DrawCommands, 2> &commands,
+                                  const glm::vec4 &clear_color) {
+  MOS_PROFILE_ZONE("gfx::Renderer::render_environment");
   for (size_t i = 0; i < environment_maps_targets.size(); i++) {
     if (scene.environment_lights[i].strength > 0.0f) {
       GLuint frame_buffer_id = environment_maps_targets[i].frame_buffer;
@@ -641,12 +1231,8 @@ void Renderer::render_environment(const Scene &scene, const glm::vec4 &clear_col
       glUniform1fv(environment_program_.fog_attenuation_factor, 1,
                    &scene.fog.attenuation_factor);
 
-      for (auto &model : scene.models) {
-        render_model(model, glm::mat4(1.0f), cube_camera,
-                     scene.lights,
-                     scene.environment_lights,
-                     scene.fog,
-                     resolution, environment_program_);
+      for (const auto &command : commands[i]) {
+        render_model(command, environment_program_);
       }
 
       cube_camera_index_[i] = cube_camera_index_[i] >= 5 ? 0 : ++cube_camera_index_[i]; //TODO PROBLEM
@@ -660,6 +1246,7 @@ void Renderer::render_environment(const Scene &scene, const glm::vec4 &clear_col
     }
   }
 
+  gpu_profiler_.begin("propagate");
   int i = cube_camera_index_[0];
 
   auto cube_camera = scene.environment_lights[0].camera(i);
@@ -688,6 +1275,7 @@ void Renderer::render_environment(const Scene &scene, const glm::vec4 &clear_col
 
   glUniform1iv(propagate_program_.side, 1, &i);
   glDrawArrays(GL_TRIANGLES, 0, 6);
+  gpu_profiler_.draw(2);
 
   glBindFramebuffer(GL_FRAMEBUFFER, 0);
   glBindTexture(GL_TEXTURE_CUBE_MAP, propagate_target_.texture);
@@ -696,72 +1284,53 @@ void Renderer::render_environment(const Scene &scene, const glm::vec4 &clear_col
 
 }
 void Renderer::load(const Mesh &mesh) {
-  if (vertex_arrays_.find(mesh.id()) == vertex_arrays_.end()) {
-    unsigned int vertex_array;
-    glGenVertexArrays(1, &vertex_array);
-    glBindVertexArray(vertex_array);
-    if (array_buffers_.find(mesh.id()) == array_buffers_.end()) {
+  MOS_PROFILE_ZONE("gfx::Renderer::load");
+  use_buffers(mesh.id());
+  std::vector<unsigned char> packed;
+  if (!vertex_arrays_.contains(mesh.id())) {
+    mesh_bounds_.insert_or_assign(mesh.id(), MeshBounds(mesh));
+    vertex_layouts_.insert_or_assign(mesh.id(), mesh.layout);
+    if (!array_buffers_.contains(mesh.id())) {
+      const auto &bounds = mesh_bounds_.at(mesh.id());
+      const auto bytes = mesh.vertices.size() * mesh.layout.stride();
       unsigned int array_buffer_id;
       glGenBuffers(1, &array_buffer_id);
       glBindBuffer(GL_ARRAY_BUFFER, array_buffer_id);
-      glBufferData(GL_ARRAY_BUFFER,
-                   mesh.vertices.size() * sizeof(Vertex),
-                   mesh.vertices.data(), GL_STATIC_DRAW);
+      glBufferData(GL_ARRAY_BUFFER, bytes,
+                   vertex_data(mesh, mesh.layout, bounds.min, bounds.max, packed), GL_STATIC_DRAW);
       glBindBuffer(GL_ARRAY_BUFFER, 0);
-      array_buffers_.insert({mesh.id(), Buffer{array_buffer_id, mesh.vertices.modified()}});
+      array_buffers_.insert(mesh.id(), Buffer{array_buffer_id, mesh.vertices.modified(), bytes});
     }
-    if (element_array_buffers_.find(mesh.id()) ==
-        element_array_buffers_.end()) {
+    if (!element_array_buffers_.contains(mesh.id())) {
       unsigned int element_array_buffer_id;
       glGenBuffers(1, &element_array_buffer_id);
-      glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, element_array_buffer_id);
-      glBufferData(GL_ELEMENT_ARRAY_BUFFER,
+      glBindBuffer(GL_COPY_WRITE_BUFFER, element_array_buffer_id);
+      glBufferData(GL_COPY_WRITE_BUFFER,
                    mesh.triangles.size() * 3 * sizeof(unsigned int),
                    mesh.triangles.data(), GL_STATIC_DRAW);
-      glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-      element_array_buffers_.insert({mesh.id(), Buffer{element_array_buffer_id, mesh.triangles.modified()}});
-    }
-    glBindBuffer(GL_ARRAY_BUFFER, array_buffers_.at(mesh.id()).id);
-    // Position
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), 0);
-
-    // Normal
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex),
-                          reinterpret_cast<const void *>(sizeof(glm::vec3)));
-
-    // Tangent
-    glVertexAttribPointer(
-        2, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex),
-        reinterpret_cast<const void *>(sizeof(glm::vec3) * 2));
-
-    // UV
-    glVertexAttribPointer(
-        3, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex),
-        reinterpret_cast<const void *>(sizeof(glm::vec3) * 3));
-
-    // Weight
-    glVertexAttribPointer(4, 1, GL_FLOAT, GL_FALSE, sizeof(Vertex),
-                          reinterpret_cast<const void *>(sizeof(glm::vec3) * 3 +
-                              sizeof(glm::vec2)));
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER,
-                 element_array_buffers_.at(mesh.id()).id);
-    glEnableVertexAttribArray(0);
-    glEnableVertexAttribArray(1);
-    glEnableVertexAttribArray(2);
-    glEnableVertexAttribArray(3);
-    glEnableVertexAttribArray(4);
-    glBindVertexArray(0);
-    vertex_arrays_.insert({mesh.id(), vertex_array});
+      glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+      element_array_buffers_.insert(mesh.id(), Buffer{element_array_buffer_id, mesh.triangles.modified(),
+                                                      mesh.triangles.size() * 3 * sizeof(unsigned int)});
+    }
+    vertex_arrays_.insert(mesh.id(), create_vertex_array(array_buffers_.at(mesh.id()).id,
+                                                         element_array_buffers_.at(mesh.id()).id,
+                                                         mesh.layout));
   }
 
   if (mesh.vertices.size() > 0 && mesh.vertices.modified() > array_buffers_.at(mesh.id()).modified) {
-    glBindBuffer(GL_ARRAY_BUFFER, array_buffers_.at(mesh.id()).id);
-    glBufferData(GL_ARRAY_BUFFER, mesh.vertices.size() * sizeof(Vertex),
-                 mesh.vertices.data(), GL_DYNAMIC_DRAW);
+    // Quantized positions follow the new bounds.
+    mesh_bounds_.insert_or_assign(mesh.id(), MeshBounds(mesh));
+    const auto &bounds = mesh_bounds_.at(mesh.id());
+    const auto &layout = vertex_layouts_.at(mesh.id());
+    auto &array_buffer = array_buffers_.at(mesh.id());
+    array_buffer.bytes = mesh.vertices.size() * layout.stride();
+    glBindBuffer(GL_ARRAY_BUFFER, array_buffer.id);
+    glBufferData(GL_ARRAY_BUFFER, array_buffer.bytes,
+                 vertex_data(mesh, layout, bounds.min, bounds.max, packed), GL_DYNAMIC_DRAW);
     glBindBuffer(GL_ARRAY_BUFFER, 0);
   }
   if (mesh.triangles.size() > 0 && mesh.triangles.modified() > element_array_buffers_.at(mesh.id()).modified) {
+    element_array_buffers_.at(mesh.id()).bytes = mesh.triangles.size() * 3 * sizeof(unsigned int);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, element_array_buffers_.at(mesh.id()).id);
     glBufferData(GL_ELEMENT_ARRAY_BUFFER,
                  mesh.triangles.size() * 3 * sizeof(unsigned int),
@@ -771,29 +1340,40 @@ void Renderer::load(const Mesh &mesh) {
   }
 }
 
-void Renderer::unload(const Mesh &mesh) {
-  if (vertex_arrays_.find(mesh.id()) != vertex_arrays_.end()) {
-    auto va_id = vertex_arrays_.at(mesh.id());
-    glDeleteVertexArrays(1, &va_id);
-    vertex_arrays_.erase(mesh.id());
-
-    if (array_buffers_.find(mesh.id()) != array_buffers_.end()) {
-      auto abo = array_buffers_.at(mesh.id());
-      glDeleteBuffers(1, &abo.id);
-      array_buffers_.erase(mesh.id());
-    }
-    if (element_array_buffers_.find(mesh.id()) !=
-        element_array_buffers_.end()) {
-      auto ebo = element_array_buffers_.at(mesh.id());
-      glDeleteBuffers(1, &ebo.id);
-      element_array_buffers_.erase(mesh.id());
-    }
+Renderer::MeshBounds::MeshBounds(const Mesh &mesh) : min(0.0f), max(0.0f) {
+  if (mesh.vertices.size() > 0) {
+    min = max = mesh.vertices[0].position;
   }
+  for (const auto &vertex : mesh.vertices) {
+    min = glm::min(min, vertex.position);
+    max = glm::max(max, vertex.position);
+  }
+}
+
+void Renderer::unload(const Mesh &mesh) {
+  unload_buffers(mesh.id());
 }
 
 void Renderer::load(const SharedMesh &mesh) {
   if (mesh) {
-    load(*mesh);
+    auto &usage = use_buffers(mesh->id());
+    // Only once, copying the owner costs atomic reference counting.
+    if (!usage.shared) {
+      usage.owner = mesh;
+      usage.shared = true;
+    }
+    if (upload_queue_ && !vertex_arrays_.contains(mesh->id())) {
+      if (pending_meshes_.insert(mesh->id()).second) {
+        Upload upload;
+        upload.mesh = mesh;
+        upload.modified = mesh->vertices.modified();
+        upload.triangles_modified = mesh->triangles.modified();
+        upload.layout = mesh->layout;
+        upload_queue_->push(std::move(upload));
+      }
+    } else {
+      load(*mesh);
+    }
   }
 }
 
@@ -808,38 +1388,44 @@ void Renderer::load(const Models &models) {
   }
 }
 
-void Renderer::render_texture_targets(const Scene &scene) {
-  for (auto &target : scene.texture_targets) {
-    if (frame_buffers_.find(target.target.id()) == frame_buffers_.end()) {
-      GLuint frame_buffer_id;
-      glGenFramebuffers(1, &frame_buffer_id);
-      glBindFramebuffer(GL_FRAMEBUFFER, frame_buffer_id);
-
-      auto buffer = TextureBuffer2D(*target.texture);
+void Renderer::load(const TextureTarget &target) {
+  if (!frame_buffers_.contains(target.target.id())) {
+    GLuint frame_buffer_id;
+    glGenFramebuffers(1, &frame_buffer_id);
+    glBindFramebuffer(GL_FRAMEBUFFER, frame_buffer_id);
 
-      textures_.insert({target.texture->id(),
-                        std::make_unique<TextureBuffer2D>(*target.texture)});
+    auto buffer = TextureBuffer2D(*target.texture);
 
-      glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
-                             GL_TEXTURE_2D, textures_.at(target.texture->id())->texture, 0);
-
-      GLuint depthrenderbuffer_id;
-      glGenRenderbuffers(1, &depthrenderbuffer_id);
-      glBindRenderbuffer(GL_RENDERBUFFER, depthrenderbuffer_id);
-      glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT,
-                            target.texture->width(),
-                            target.texture->height());
-      glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,
-                                GL_RENDERBUFFER, depthrenderbuffer_id);
-      glBindRenderbuffer(GL_RENDERBUFFER, 0);
-      render_buffers.insert({target.target.id(), depthrenderbuffer_id});
-
-      if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
-        throw std::runtime_error("Framebuffer incomplete.");
-      }
+    textures_.insert(target.texture->id(), std::make_unique<TextureBuffer2D>(*target.texture));
+    textures_.at(target.texture->id())->usage.pinned = true;
 
-      frame_buffers_.insert({target.target.id(), frame_buffer_id});
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                           GL_TEXTURE_2D, textures_.at(target.texture->id())->texture, 0);
+
+    GLuint depthrenderbuffer_id;
+    glGenRenderbuffers(1, &depthrenderbuffer_id);
+    glBindRenderbuffer(GL_RENDERBUFFER, depthrenderbuffer_id);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT,
+                          target.texture->width(),
+                          target.texture->height());
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,
+                              GL_RENDERBUFFER, depthrenderbuffer_id);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+    render_buffers.insert(target.target.id(), depthrenderbuffer_id);
+
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+      throw std::runtime_error("Framebuffer incomplete.");
     }
+
+    frame_buffers_.insert(target.target.id(), frame_buffer_id);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  }
+}
+
+void Renderer::render_texture_targets(const SceneView &scene, const std::vector<DrawCommands> &commands) {
+  MOS_PROFILE_ZONE("gfx::Renderer::render_texture_targets");
+  for (size_t i = 0; i < scene.texture_targets.size(); i++) {
+    const auto &target = scene.texture_targets[i];
     auto fb = frame_buffers_.at(target.target.id());
     glBindFramebuffer(GL_FRAMEBUFFER, fb);
 
@@ -852,49 +1438,514 @@ void Renderer::render_texture_targets(const Scene &scene) {
 
     render_scene(target.camera,
                  scene,
+                 commands[i],
                  glm::ivec2(target.texture->width(), target.texture->height()));
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
-    glBindTexture(GL_TEXTURE_2D, texture_id);
-    glGenerateMipmap(GL_TEXTURE_2D);
+    if (target.texture->mipmaps) {
+      glBindTexture(GL_TEXTURE_2D, texture_id);
+      glGenerateMipmap(GL_TEXTURE_2D);
+    }
     glBindTexture(GL_TEXTURE_2D, 0);
   }
 }
 
-void Renderer::render_model_depth(const Model &model,
-                                  const glm::mat4 &transform,
-                                  const Camera &camera,
-                                  const glm::vec2 &resolution,
-                                  const DepthProgram &program) {
-  const glm::mat4 mvp = camera.projection * camera.view * transform * model.transform;
-
-  if (model.mesh) {
-    glBindVertexArray(vertex_arrays_.at(model.mesh->id()));
+void Renderer::render_model_depth(const DrawCommand &command,
+                                  const DepthProgram &program,
+                                  const bool opaque_only,
+                                  Occlusion *occlusion) {
+  if (command.vertex_array && opaque_only && command.transparent) {
+    // Keep the traversal in step with the culled commands.
+    if (occlusion) {
+      occlusion->next++;
+    }
+  } else if (command.vertex_array) {
+    glBindVertexArray(command.vertex_array);
     glUniformMatrix4fv(program.model_view_projection_matrix, 1, GL_FALSE,
-                       &mvp[0][0]);
-    const int num_elements = model.mesh ? model.mesh->triangles.size() * 3 : 0;
-    glDrawElements(GL_TRIANGLES, num_elements, GL_UNSIGNED_INT, 0);
+                       &command.model_view_projection[0][0]);
+    glUniform3fv(program.position_offset, 1, glm::value_ptr(command.position_offset));
+    glUniform3fv(program.position_scale, 1, glm::value_ptr(command.position_scale));
+    if (occlusion) {
+      occlusion->draw_elements();
+    } else {
+      glDrawElements(GL_TRIANGLES, command.count, GL_UNSIGNED_INT, 0);
+    }
+    gpu_profiler_.draw(command.count / 3);
+  }
+}
+
+void Renderer::gather_draws(const DrawCommands &commands, Occlusion &occlusion) const {
+  // Skip the same meshes as the draw traversals.
+  for (const auto &command : commands) {
+    if (command.vertex_array) {
+      occlusion.bounds.push_back(command.bounds);
+      occlusion.commands.push_back(Occlusion::Command{GLuint(command.count), 1, 0, 0, 0});
+    }
+  }
+}
+
+void Renderer::build_commands(const SceneNodes &nodes,
+                              const size_t begin,
+                              const size_t end,
+                              const glm::mat4 &view_projection,
+                              const Lights &lights,
+                              const Pass pass,
+                              DrawCommands &commands) const {
+  static const glm::mat4 bias(0.5, 0.0, 0.0, 0.0, 0.0, 0.5, 0.0, 0.0, 0.0, 0.0,
+                              0.5, 0.0, 0.5, 0.5, 0.5, 1.0);
+  for (size_t i = begin; i < end; i++) {
+    const auto &node = nodes.nodes[i];
+    const auto &model = *node.model;
+    auto &command = commands[i];
+    command.node = &node;
+    command.vertex_array = 0;
+    if (!resident(model.mesh)) {
+      continue;
+    }
+    const auto &material = model.material;
+    command.vertex_array = vertex_arrays_.at(model.mesh->id());
+    command.count = GLsizei(model.mesh->triangles.size() * 3);
+    // Map alpha blends the albedo and emission maps, so it can see through otherwise opaque materials.
+    const auto alpha = [](const SharedTexture2D &texture) { return texture && Texture::alpha(texture->format); };
+    command.transparent = material.opacity < 1.0f || alpha(material.albedo_map) || alpha(material.emission_map);
+    const auto &mesh_bounds = mesh_bounds_.at(model.mesh->id());
+    const auto &layout = vertex_layouts_.at(model.mesh->id());
+    const bool quantized = layout.position == VertexLayout::Position::QUANTIZED;
+    command.position_offset = quantized ? mesh_bounds.min : glm::vec3(0.0f);
+    command.position_scale = quantized ? mesh_bounds.max - mesh_bounds.min : glm::vec3(1.0f);
+    command.octahedral = layout.direction == VertexLayout::Direction::OCTAHEDRAL;
+    command.model_view_projection = view_projection * node.world;
+    if (pass == Pass::DEPTH) {
+      continue;
+    }
+
+    for (size_t l = 0; l < lights.size(); l++) {
+      command.depth_bias_mvps[l] = bias * lights[l].camera.projection * lights[l].camera.view * node.world;
+    }
+    const bool mapped = material.albedo_map || material.emission_map;
+    command.albedo = glm::vec4(material.albedo, mapped ? 0.0f : 1.0f);
+    command.emission = glm::vec4(material.emission, mapped ? 0.0f : 1.0f);
+    command.textures = {texture_or(material.albedo_map, black_texture_),
+                        texture_or(material.emission_map, black_texture_),
+                        texture_or(material.normal_map, black_texture_),
+                        texture_or(material.metallic_map, black_texture_),
+                        texture_or(material.roughness_map, black_texture_),
+                        texture_or(material.ambient_occlusion_map, white_texture_)};
+    if (pass == Pass::ENVIRONMENT) {
+      continue;
+    }
+
+    glm::vec3 min(std::numeric_limits<float>::max());
+    glm::vec3 max(std::numeric_limits<float>::lowest());
+    for (int c = 0; c < 8; c++) {
+      const glm::vec3 corner((c & 1) ? mesh_bounds.max.x : mesh_bounds.min.x,
+                             (c & 2) ? mesh_bounds.max.y : mesh_bounds.min.y,
+                             (c & 4) ? mesh_bounds.max.z : mesh_bounds.min.z);
+      const auto position = glm::vec3(node.world * glm::vec4(corner, 1.0f));
+      min = glm::min(min, position);
+      max = glm::max(max, position);
+    }
+    command.bounds = Occlusion::Bounds{glm::vec4(min, 0.0f), glm::vec4(max, command.transparent ? 1.0f : 0.0f)};
+  }
+}
+
+void Renderer::build_frame_commands(const SceneViews scenes) {
+  MOS_PROFILE_ZONE("gfx::Renderer::build_frame_commands");
+  struct CommandChunk {
+    const SceneNodes *nodes;
+    size_t begin;
+    size_t end;
+    glm::mat4 view_projection;
+    const Lights *lights;
+    Pass pass;
+    DrawCommands *commands;
+  };
+  JobCounter counter;
+
+  // Split each pass in chunks of nodes, every chunk writes its own commands.
+  const auto add_pass = [&](const SceneNodes &nodes,
+                            const glm::mat4 &view_projection,
+                            const Lights &lights,
+                            const Pass pass,
+                            DrawCommands &commands) {
+    const size_t count = nodes.nodes.size();
+    commands.resize(count);
+    for (size_t begin = 0; begin < count; begin += command_chunk) {
+      const size_t end = std::min(begin + command_chunk, count);
+      // Two pointers are stored in the job itself, the rest lives in frame memory.
+      auto *chunk = new (frame_arena_.allocate(sizeof(CommandChunk), alignof(CommandChunk)))
+          CommandChunk{&nodes, begin, end, view_projection, &lights, pass, &commands};
+      Jobs::run([this, chunk]() {
+        build_commands(*chunk->nodes, chunk->begin, chunk->end, chunk->view_projection,
+                       *chunk->lights, chunk->pass, *chunk->commands);
+      }, counter);
+    }
+  };
+
+  const auto &scene = scenes[0];
+  const auto &nodes = scene_nodes_[0];
+  for (size_t i = 0; i < commands_.shadow_maps.size(); i++) {
+    commands_.shadow_maps[i].clear();
+    if (scene.lights[i].strength > 0.0f) {
+      const auto &camera = scene.lights[i].camera;
+      add_pass(nodes, camera.projection * camera.view, scene.lights, Pass::DEPTH, commands_.shadow_maps[i]);
+    }
+  }
+  for (size_t i = 0; i < commands_.environment_maps.size(); i++) {
+    commands_.environment_maps[i].clear();
+    if (scene.environment_lights[i].strength > 0.0f) {
+      const auto camera = scene.environment_lights[i].camera(cube_camera_index_[i]);
+      add_pass(nodes, camera.projection * camera.view, scene.lights, Pass::ENVIRONMENT,
+               commands_.environment_maps[i]);
+    }
+  }
+  commands_.texture_targets.resize(scene.texture_targets.size());
+  for (size_t i = 0; i < scene.texture_targets.size(); i++) {
+    const auto &camera = scene.texture_targets[i].camera;
+    add_pass(nodes, camera.projection * camera.view, scene.lights, Pass::STANDARD, commands_.texture_targets[i]);
+  }
+  commands_.scenes.resize(scenes.size());
+  for (size_t i = 0; i < scenes.size(); i++) {
+    const auto &camera = scenes[i].camera;
+    add_pass(scene_nodes_[i], camera.projection * camera.view, scenes[i].lights, Pass::STANDARD,
+             commands_.scenes[i]);
+  }
+  Jobs::wait(counter);
+}
+
+void Renderer::SceneNodes::update(const Span<const Model> models) {
+  MOS_PROFILE_ZONE("gfx::Renderer::SceneNodes::update");
+  const size_t previous = nodes.size();
+  size_t count = 0;
+  roots.clear();
+  for (const auto &model : models) {
+    roots.push_back(count);
+    add(model, npos, previous, count);
   }
+  roots.push_back(count);
+  nodes.resize(count);
+
+  // Subtrees of top level models are independent.
+  const auto compute = [this](const size_t root) {
+    for (size_t i = roots[root]; i < roots[root + 1]; i++) {
+      auto &node = nodes[i];
+      if (node.dirty) {
+        node.world = node.parent == npos ? node.local : nodes[node.parent].world * node.local;
+        node.normal = glm::inverseTranspose(glm::mat3(node.world));
+      }
+    }
+  };
+  const size_t root_count = roots.size() - 1;
+  if (nodes.size() < parallel_nodes || root_count < 2) {
+    for (size_t root = 0; root < root_count; root++) {
+      compute(root);
+    }
+  } else {
+    // Runs of top level models with about the same node count, a few per thread.
+    const size_t chunk_nodes = std::max<size_t>(nodes.size() / ((Jobs::workers() + 1) * 4), 1);
+    chunks_.clear();
+    for (size_t root = 0; root < root_count; root++) {
+      if (chunks_.empty() || roots[root] - roots[chunks_.back()] >= chunk_nodes) {
+        chunks_.push_back(root);
+      }
+    }
+    chunks_.push_back(root_count);
+    Jobs::parallel_for(0, chunks_.size() - 1, 1, [&](const size_t begin, const size_t end) {
+      for (size_t root = chunks_[begin]; root < chunks_[end]; root++) {
+        compute(root);
+      }
+    });
+  }
+}
+
+void Renderer::SceneNodes::add(const Model &model, const size_t parent, const size_t previous, size_t &count) {
+  const size_t index = count++;
+  if (index == nodes.size()) {
+    nodes.emplace_back();
+  }
+  auto &node = nodes[index];
+  // A node keeps its matrices while it and its ancestors are unchanged.
+  node.dirty = index >= previous || node.parent != parent || node.local != model.transform
+      || (parent != npos && nodes[parent].dirty);
+  node.model = &model;
+  node.parent = parent;
+  node.local = model.transform;
   for (const auto &child : model.models) {
-    render_model_depth(child, transform * model.transform, camera, resolution, program);
+    add(child, index, previous, count);
+  }
+}
+
+void Renderer::cull(Occlusion &occlusion, const Camera &camera, const int phase) {
+  MOS_PROFILE_ZONE("gfx::Renderer::cull");
+  const auto draw_count = GLuint(occlusion.bounds.size());
+  if (phase == 0) {
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, occlusion.bounds_buffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, draw_count * sizeof(Occlusion::Bounds),
+                 occlusion.bounds.data(), GL_STREAM_DRAW);
+    // Both phases start from the same commands.
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, occlusion.command_buffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, 2 * draw_count * sizeof(Occlusion::Command), nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, draw_count * sizeof(Occlusion::Command),
+                    occlusion.commands.data());
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, draw_count * sizeof(Occlusion::Command),
+                    draw_count * sizeof(Occlusion::Command), occlusion.commands.data());
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, occlusion.visible_buffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, draw_count * sizeof(GLuint), nullptr, GL_STREAM_DRAW);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+  }
+  if (draw_count == 0) {
+    return;
+  }
+
+  const auto &program = occlusion_cull_program_;
+  const glm::mat4 view_projection = camera.projection * camera.view;
+  glUseProgram(program.program);
+  glActiveTexture(GL_TEXTURE11);
+  glBindTexture(GL_TEXTURE_2D, occlusion.depth_pyramid);
+  glUniform1i(program.depth_pyramid, 11);
+  glUniformMatrix4fv(program.view_projection, 1, GL_FALSE, &view_projection[0][0]);
+  glUniform2iv(program.resolution, 1, glm::value_ptr(occlusion.pyramid_resolution));
+  glUniform1i(program.levels, occlusion.pyramid_levels);
+  glUniform1ui(program.draw_count, draw_count);
+  glUniform1i(program.phase, phase);
+
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, occlusion.bounds_buffer);
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, occlusion.command_buffer);
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, occlusion.visible_buffer);
+  glDispatchCompute((draw_count + 63) / 64, 1, 1);
+  glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+}
+
+void Renderer::build_depth_pyramid(Occlusion &occlusion, const glm::ivec2 &resolution) {
+  MOS_PROFILE_ZONE("gfx::Renderer::build_depth_pyramid");
+  const auto &program = depth_pyramid_program_;
+  glUseProgram(program.program);
+  glActiveTexture(GL_TEXTURE11);
+  glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, standard_target_.depth_texture);
+  glUniform1i(program.depth_texture, 11);
+  glUniform1i(program.samples, StandardTarget::samples);
+
+  auto source_resolution = resolution;
+  int level = 0;
+  for (; level < occlusion.pyramid_levels_allocated; level++) {
+    const auto destination_resolution = level == 0 ? resolution : glm::max(source_resolution / 2, glm::ivec2(1));
+    glUniform1i(program.level, level);
+    glUniform2iv(program.source_resolution, 1, glm::value_ptr(source_resolution));
+    glBindImageTexture(0, occlusion.depth_pyramid, level, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+    if (level > 0) {
+      glBindImageTexture(1, occlusion.depth_pyramid, level - 1, GL_FALSE, 0, GL_READ_ONLY, GL_R32F);
+    }
+    glDispatchCompute((destination_resolution.x + 7) / 8, (destination_resolution.y + 7) / 8, 1);
+    glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+    source_resolution = destination_resolution;
+    if (destination_resolution == glm::ivec2(1)) {
+      level++;
+      break;
+    }
+  }
+  glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+  glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, 0);
+  occlusion.pyramid_resolution = resolution;
+  occlusion.pyramid_levels = level;
+}
+
+Renderer::Occlusion::Occlusion(const glm::ivec2 &resolution)
+    : pyramid_resolution(0),
+      pyramid_levels(0),
+      pyramid_levels_allocated(int(std::floor(std::log2(float(glm::max(resolution.x, resolution.y))))) + 1),
+      next(0),
+      phase(Phase::FIRST) {
+  glGenBuffers(1, &bounds_buffer);
+  glGenBuffers(1, &command_buffer);
+  glGenBuffers(1, &visible_buffer);
+
+  glGenTextures(1, &depth_pyramid);
+  glBindTexture(GL_TEXTURE_2D, depth_pyramid);
+  glTexStorage2D(GL_TEXTURE_2D, pyramid_levels_allocated, GL_R32F, resolution.x, resolution.y);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+Renderer::Occlusion::~Occlusion() {
+  glDeleteTextures(1, &depth_pyramid);
+  glDeleteBuffers(1, &visible_buffer);
+  glDeleteBuffers(1, &command_buffer);
+  glDeleteBuffers(1, &bounds_buffer);
+}
+
+void Renderer::Occlusion::draw_elements() {
+  const size_t draw = next++;
+  if (phase != Phase::SECOND) {
+    glDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT,
+                           reinterpret_cast<const void *>(draw * sizeof(Command)));
+  }
+  if (phase != Phase::FIRST) {
+    glDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT,
+                           reinterpret_cast<const void *>((commands.size() + draw) * sizeof(Command)));
+  }
+}
+
+Renderer::Overdraw::Overdraw() : samples{0.0f, 0.0f}, pending{false, false}, index(0), value(0.0f), prepass(false) {
+  glGenQueries(queries.size(), queries.data());
+}
+
+Renderer::Overdraw::~Overdraw() {
+  glDeleteQueries(queries.size(), queries.data());
+}
+
+void Renderer::Overdraw::begin() {
+  // Read the query issued two frames ago, without stalling.
+  if (pending[index]) {
+    GLint available = 0;
+    glGetQueryObjectiv(queries[index], GL_QUERY_RESULT_AVAILABLE, &available);
+    if (available) {
+      GLuint64 passed = 0;
+      glGetQueryObjectui64v(queries[index], GL_QUERY_RESULT, &passed);
+      value = samples[index] > 0.0f ? float(passed) / samples[index] : 0.0f;
+      // Hysteresis, so the choice does not flip every frame.
+      if (!prepass && value > 1.5f) {
+        prepass = true;
+      } else if (prepass && value < 1.2f) {
+        prepass = false;
+      }
+    }
+    pending[index] = false;
   }
+  glBeginQuery(GL_SAMPLES_PASSED, queries[index]);
+}
+
+void Renderer::Overdraw::end(const glm::ivec2 &resolution, const int samples_per_pixel) {
+  glEndQuery(GL_SAMPLES_PASSED);
+  samples[index] = float(resolution.x) * float(resolution.y) * float(samples_per_pixel);
+  pending[index] = true;
+  index = (index + 1) % queries.size();
 }
 
 void Renderer::render(const Scenes &scenes, const glm::vec4 &color, const glm::ivec2 &resolution) {
-  for (auto &scene : scenes) {
-    load(scene.models);
+  // Views live in frame memory, which stays valid through the next frame.
+  FrameVector<SceneView> views{FrameAllocator<SceneView>(frame_arena_)};
+  views.assign(scenes.begin(), scenes.end());
+  render(SceneViews(views), color, resolution);
+}
+
+void Renderer::render(const SceneViews scenes, const glm::vec4 &color, const glm::ivec2 &resolution) {
+  render_frame(scenes, color, resolution, 0);
+}
+
+void Renderer::render_offscreen(const Scenes &scenes, const glm::vec4 &color, const glm::ivec2 &resolution) {
+  FrameVector<SceneView> views{FrameAllocator<SceneView>(frame_arena_)};
+  views.assign(scenes.begin(), scenes.end());
+  render_offscreen(SceneViews(views), color, resolution);
+}
+
+void Renderer::render_offscreen(const SceneViews scenes, const glm::vec4 &color, const glm::ivec2 &resolution) {
+  if (!offscreen_target_ || offscreen_target_->resolution != resolution) {
+    offscreen_target_ = std::make_unique<OffscreenTarget>(resolution);
   }
-  render_shadow_maps(scenes[0].models, scenes[0].lights);
-  render_environment(scenes[0], color);
-  render_texture_targets(scenes[0]);
+  auto &target = *offscreen_target_;
+  render_frame(scenes, color, resolution, target.frame_buffer);
 
+  // The oldest readback was never collected, drop it.
+  if (target.fences[target.index]) {
+    glDeleteSync(target.fences[target.index]);
+  }
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, target.frame_buffer);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, target.pixel_buffers[target.index]);
+  glPixelStorei(GL_PACK_ALIGNMENT, 1);
+  glReadPixels(0, 0, resolution.x, resolution.y, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+  target.fences[target.index] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  target.index = (target.index + 1) % target.pixel_buffers.size();
+}
+
+std::optional<std::vector<unsigned char>> Renderer::read_pixels(const bool wait) {
+  if (!offscreen_target_) {
+    return std::nullopt;
+  }
+  auto &target = *offscreen_target_;
+  for (size_t i = 0; i < target.pixel_buffers.size(); i++) {
+    const auto index = (target.index + i) % target.pixel_buffers.size();
+    auto &fence = target.fences[index];
+    if (!fence) {
+      continue;
+    }
+    const GLuint64 timeout = wait ? GLuint64(1000000000) : 0;
+    const auto status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, timeout);
+    if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) {
+      return std::nullopt;
+    }
+    glDeleteSync(fence);
+    fence = nullptr;
+
+    const auto size = size_t(target.resolution.x) * size_t(target.resolution.y) * 4;
+    std::vector<unsigned char> pixels(size);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, target.pixel_buffers[index]);
+    const auto *data = static_cast<const unsigned char *>(
+        glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, GLsizeiptr(size), GL_MAP_READ_BIT));
+    if (data) {
+      std::copy(data, data + size, pixels.begin());
+      glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    return pixels;
+  }
+  return std::nullopt;
+}
+
+void Renderer::render_frame(const SceneViews scenes,
+                            const glm::vec4 &color,
+                            const glm::ivec2 &resolution,
+                            const GLuint frame_buffer) {
+  MOS_PROFILE_ZONE("gfx::Renderer::render");
+  gpu_profiler_.begin_frame();
+  frame_arena_.frame();
+  finish_uploads();
+  for (const auto &scene : scenes) {
+    for (const auto &model : scene.models) {
+      load(model);
+    }
+  }
+  scene_nodes_.resize(scenes.size());
+  for (size_t i = 0; i < scenes.size(); i++) {
+    scene_nodes_[i].update(scenes[i].models);
+  }
+  for (const auto &target : scenes[0].texture_targets) {
+    load(target);
+  }
+  build_frame_commands(scenes);
+  gpu_profiler_.begin("shadow_maps");
+  render_shadow_maps(commands_.shadow_maps, scenes[0].lights);
+  gpu_profiler_.begin("environment");
+  render_environment(scenes[0], commands_.environment_maps, color);
+  gpu_profiler_.begin("texture_targets");
+  render_texture_targets(scenes[0], commands_.texture_targets);
+
+  update_resolution_scale();
+  const auto render_resolution = glm::clamp(glm::ivec2(glm::vec2(resolution) * resolution_scale_),
+                                            glm::ivec2(1), standard_target_.resolution);
+  const auto uv_scale = glm::vec2(render_resolution) / glm::vec2(standard_target_.resolution);
+
+  gpu_profiler_.begin("scene");
   glBindFramebuffer(GL_FRAMEBUFFER, standard_target_.frame_buffer);
   clear(color);
 
-  for (auto it = scenes.begin(); it != scenes.end(); it++) {
-    render_scene(it->camera, *it, resolution);
+  while (overdraws_.size() < scenes.size()) {
+    overdraws_.push_back(std::make_unique<Overdraw>());
+  }
+  while (occlusions_.size() < scenes.size()) {
+    occlusions_.push_back(std::make_unique<Occlusion>(standard_target_.resolution));
+  }
+  for (size_t i = 0; i < scenes.size(); i++) {
+    render_scene(scenes[i].camera, scenes[i], commands_.scenes[i], render_resolution,
+                 overdraws_[i].get(), occlusions_[i].get());
   }
 
   //RenderQuad
+  gpu_profiler_.begin("multisample");
+  glViewport(0, 0, render_resolution.x, render_resolution.y);
   glBindFramebuffer(GL_FRAMEBUFFER, multi_target_.frame_buffer);
   glUseProgram(multisample_program_.program);
 
@@ -907,37 +1958,59 @@ void Renderer::render(const Scenes &scenes, const glm::vec4 &color, const glm::i
   glActiveTexture(GL_TEXTURE1);
   glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, standard_target_.depth_texture);
   glUniform1i(multisample_program_.depth_texture, 1);
+  glUniform2fv(multisample_program_.uv_scale, 1, glm::value_ptr(uv_scale));
 
   glDrawArrays(GL_TRIANGLES, 0, 6);
+  gpu_profiler_.draw(2);
 
-  glViewport(0, 0, GLsizei(resolution.x / 4.0f), GLsizei(resolution.y / 4.0f));
+  // Each bloom level only holds the scaled part of the image.
+  FrameVector<glm::ivec2> bloom_viewports{FrameAllocator<glm::ivec2>(frame_arena_)};
+  for (const auto &level_resolution : bloom_target_.resolutions) {
+    bloom_viewports.push_back(glm::max(glm::ivec2(glm::ceil(glm::vec2(level_resolution) * uv_scale)),
+                                       glm::ivec2(1)));
+  }
+  auto level_uv_scale = [&](const size_t i) {
+    return glm::vec2(bloom_viewports[i]) / glm::vec2(bloom_target_.resolutions[i]);
+  };
 
-  glBindFramebuffer(GL_FRAMEBUFFER, blur_target0_.frame_buffer);
-  glUseProgram(blur_program_.program);
+  gpu_profiler_.begin("bloom_downsample");
+  glBindFramebuffer(GL_FRAMEBUFFER, bloom_target_.frame_buffer);
+  glUseProgram(bloom_downsample_program_.program);
   glBindVertexArray(quad_.vertex_array);
   glActiveTexture(GL_TEXTURE0);
-  glBindTexture(GL_TEXTURE_2D, multi_target_.bright_texture);
-  glUniform1i(blur_program_.color_texture, 0);
-  GLint horizontal = false;
-  glUniform1iv(blur_program_.horizontal, 1, &horizontal);
-  glDrawArrays(GL_TRIANGLES, 0, 6);
-
-  for (int i = 0; i < 5; i++) {
-    horizontal = (i % 2 == 0);
-    glBindFramebuffer(GL_FRAMEBUFFER, horizontal ? blur_target1_.frame_buffer : blur_target0_.frame_buffer);
-    glUseProgram(blur_program_.program);
-    glBindVertexArray(quad_.vertex_array);
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, horizontal ? blur_target0_.texture : blur_target1_.texture);
-    glUniform1i(blur_program_.color_texture, 0);
-    glUniform1iv(blur_program_.horizontal, 1, &horizontal);
+  glUniform1i(bloom_downsample_program_.color_texture, 0);
+  GLuint source = multi_target_.bright_texture;
+  auto source_uv_scale = uv_scale;
+  for (size_t i = 0; i < bloom_target_.textures.size(); i++) {
+    glViewport(0, 0, bloom_viewports[i].x, bloom_viewports[i].y);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, bloom_target_.textures[i], 0);
+    glBindTexture(GL_TEXTURE_2D, source);
+    glUniform2fv(bloom_downsample_program_.uv_scale, 1, glm::value_ptr(source_uv_scale));
+    glDrawArrays(GL_TRIANGLES, 0, 6);
+    gpu_profiler_.draw(2);
+    source = bloom_target_.textures[i];
+    source_uv_scale = level_uv_scale(i);
+  }
 
+  gpu_profiler_.begin("bloom_upsample");
+  glUseProgram(bloom_upsample_program_.program);
+  glUniform1i(bloom_upsample_program_.color_texture, 0);
+  glUniform1f(bloom_upsample_program_.radius, bloom_radius);
+  glBlendFunc(GL_ONE, GL_ONE);
+  for (size_t i = bloom_target_.textures.size() - 1; i > 0; i--) {
+    glViewport(0, 0, bloom_viewports[i - 1].x, bloom_viewports[i - 1].y);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, bloom_target_.textures[i - 1], 0);
+    glBindTexture(GL_TEXTURE_2D, bloom_target_.textures[i]);
+    glUniform2fv(bloom_upsample_program_.uv_scale, 1, glm::value_ptr(level_uv_scale(i)));
     glDrawArrays(GL_TRIANGLES, 0, 6);
+    gpu_profiler_.draw(2);
   }
+  glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
+  gpu_profiler_.begin("bloom");
   glViewport(0, 0, resolution.x, resolution.y);
   //Render to screen
-  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  glBindFramebuffer(GL_FRAMEBUFFER, frame_buffer);
   glUseProgram(bloom_program_.program);
 
   glBindVertexArray(quad_.vertex_array);
@@ -947,12 +2020,22 @@ void Renderer::render(const Scenes &scenes, const glm::vec4 &color, const glm::i
   glUniform1i(bloom_program_.color_texture, 0);
 
   glActiveTexture(GL_TEXTURE1);
-  glBindTexture(GL_TEXTURE_2D, blur_target0_.texture);
+  glBindTexture(GL_TEXTURE_2D, bloom_target_.textures[0]);
   glUniform1i(bloom_program_.bright_color_texture, 1);
-  float strength = 0.1f;
+  // Each upsample adds a level, keep the total independent of chain length.
+  float strength = bloom_strength / float(bloom_target_.textures.size());
   glUniform1fv(bloom_program_.strength, 1, &strength);
+  glUniform2fv(bloom_program_.uv_scale, 1, glm::value_ptr(uv_scale));
+  const float sharpness = resolution_scale_ < 1.0f ? dynamic_resolution.sharpness : 0.0f;
+  glUniform1f(bloom_program_.sharpness, sharpness);
 
   glDrawArrays(GL_TRIANGLES, 0, 6);
+  gpu_profiler_.draw(2);
+  gpu_profiler_.end();
+
+  stream_textures();
+  release_unused();
+  frame_++;
 }
 
 Renderer::DepthProgram::DepthProgram() {
@@ -963,17 +2046,53 @@ Renderer::DepthProgram::DepthProgram() {
   const auto vertex_shader = Shader(vert_source, GL_VERTEX_SHADER, name);
   const auto fragment_shader = Shader(frag_source, GL_FRAGMENT_SHADER, name);
 
-  program = glCreateProgram();
-
   glAttachShader(program, vertex_shader.id);
   glAttachShader(program, fragment_shader.id);
-  glBindAttribLocation(program, 0, "position");
+  // Attribute locations are set in the shader, to match VertexLayout.
   link(name);
   check(name);
   glDetachShader(program, vertex_shader.id);
   glDetachShader(program, fragment_shader.id);
 
   model_view_projection_matrix = glGetUniformLocation(program, "model_view_projection");
+  position_offset = glGetUniformLocation(program, "position_offset");
+  position_scale = glGetUniformLocation(program, "position_scale");
+}
+
+Renderer::DepthPyramidProgram::DepthPyramidProgram() {
+  std::string name = "depth_pyramid";
+  auto comp_source = text("assets/shaders/" + name + ".comp");
+
+  const auto compute_shader = Shader(comp_source, GL_COMPUTE_SHADER, name);
+
+  glAttachShader(program, compute_shader.id);
+  link(name);
+  check(name);
+  glDetachShader(program, compute_shader.id);
+
+  depth_texture = glGetUniformLocation(program, "depth_texture");
+  samples = glGetUniformLocation(program, "samples");
+  level = glGetUniformLocation(program, "level");
+  source_resolution = glGetUniformLocation(program, "source_resolution");
+}
+
+Renderer::OcclusionCullProgram::OcclusionCullProgram() {
+  std::string name = "occlusion_cull";
+  auto comp_source = text("assets/shaders/" + name + ".comp");
+
+  const auto compute_shader = Shader(comp_source, GL_COMPUTE_SHADER, name);
+
+  glAttachShader(program, compute_shader.id);
+  link(name);
+  check(name);
+  glDetachShader(program, compute_shader.id);
+
+  depth_pyramid = glGetUniformLocation(program, "depth_pyramid");
+  view_projection = glGetUniformLocation(program, "view_projection");
+  resolution = glGetUniformLocation(program, "resolution");
+  levels = glGetUniformLocation(program, "levels");
+  draw_count = glGetUniformLocation(program, "draw_count");
+  phase = glGetUniformLocation(program, "phase");
 }
 
 Renderer::EnvironmentProgram::EnvironmentProgram() {
@@ -992,11 +2111,6 @@ Renderer::EnvironmentProgram::EnvironmentProgram() {
   glAttachShader(program, functions_fragment_shader.id);
   glAttachShader(program, fragment_shader.id);
 
-  glBindAttribLocation(program, 0, "position");
-  glBindAttribLocation(program, 1, "normal");
-  glBindAttribLocation(program, 2, "tangent");
-  glBindAttribLocation(program, 3, "uv");
-
   link(name);
   check(name);
 
@@ -1007,6 +2121,9 @@ Renderer::EnvironmentProgram::EnvironmentProgram() {
   model_view_projection_matrix = (glGetUniformLocation(program, "model_view_projection"));
   model_matrix = glGetUniformLocation(program, "model");
   normal_matrix = glGetUniformLocation(program, "normal_matrix");
+  position_offset = glGetUniformLocation(program, "position_offset");
+  position_scale = glGetUniformLocation(program, "position_scale");
+  octahedral = glGetUniformLocation(program, "octahedral");
   for (size_t i = 0; i < 2; i++) {
     depth_bias_mvps[i] = glGetUniformLocation(program,
                                               std::string("depth_bias_model_view_projections[" + std::to_string(i)
@@ -1065,11 +2182,6 @@ Renderer::StandardProgram::StandardProgram() {
   glAttachShader(program, functions_fragment_shader.id);
   glAttachShader(program, fragment_shader.id);
 
-  glBindAttribLocation(program, 0, "position");
-  glBindAttribLocation(program, 1, "normal");
-  glBindAttribLocation(program, 2, "tangent");
-  glBindAttribLocation(program, 3, "uv");
-
   link(name);
   check(name);
 
@@ -1080,6 +2192,9 @@ Renderer::StandardProgram::StandardProgram() {
   model_view_projection_matrix = (glGetUniformLocation(program, "model_view_projection"));
   model_matrix = glGetUniformLocation(program, "model");
   normal_matrix = glGetUniformLocation(program, "normal_matrix");
+  position_offset = glGetUniformLocation(program, "position_offset");
+  position_scale = glGetUniformLocation(program, "position_scale");
+  octahedral = glGetUniformLocation(program, "octahedral");
   for (size_t i = 0; i < 2; i++) {
     depth_bias_mvps[i] = glGetUniformLocation(program,
                                               std::string("depth_bias_model_view_projections[" + std::to_string(i)
@@ -1183,6 +2298,31 @@ Renderer::BoxProgram::BoxProgram() {
   mvp = glGetUniformLocation(program, "model_view_projection");
 }
 
+Renderer::TextProgram::TextProgram() {
+  std::string name = "text";
+  std::string vert_source = text("assets/shaders/" + name + ".vert");
+  std::string frag_source = text("assets/shaders/" + name + ".frag");
+
+  const auto vertex_shader = Shader(vert_source, GL_VERTEX_SHADER, name);
+  const auto fragment_shader = Shader(frag_source, GL_FRAGMENT_SHADER, name);
+
+  glAttachShader(program, vertex_shader.id);
+  glAttachShader(program, fragment_shader.id);
+  glBindAttribLocation(program, 0, "position");
+  glBindAttribLocation(program, 1, "uv");
+  glBindAttribLocation(program, 2, "color");
+
+  link(name);
+  check(name);
+
+  glDetachShader(program, vertex_shader.id);
+  glDetachShader(program, fragment_shader.id);
+
+  view_projection = glGetUniformLocation(program, "view_projection");
+  atlas = glGetUniformLocation(program, "atlas");
+  distance_field = glGetUniformLocation(program, "distance_field");
+}
+
 Renderer::MultisampleProgram::MultisampleProgram() {
   std::string name = "multisample";
   auto vert_source = text("assets/shaders/" + name + ".vert");
@@ -1203,6 +2343,7 @@ Renderer::MultisampleProgram::MultisampleProgram() {
 
   color_texture = glGetUniformLocation(program, "color_texture");
   depth_texture = glGetUniformLocation(program, "depth_texture");
+  uv_scale = glGetUniformLocation(program, "uv_scale");
 }
 
 Renderer::BloomProgram::BloomProgram() {
@@ -1226,11 +2367,13 @@ Renderer::BloomProgram::BloomProgram() {
   color_texture = glGetUniformLocation(program, "color_texture");
   bright_color_texture = glGetUniformLocation(program, "bright_color_texture");
   strength = glGetUniformLocation(program, "strength");
+  uv_scale = glGetUniformLocation(program, "uv_scale");
+  sharpness = glGetUniformLocation(program, "sharpness");
 
 }
 
-Renderer::BlurProgram::BlurProgram() {
-  std::string name = "blur";
+Renderer::BloomDownsampleProgram::BloomDownsampleProgram() {
+  std::string name = "bloom_downsample";
   auto vert_source = text("assets/shaders/" + name + ".vert");
   auto frag_source = text("assets/shaders/" + name + ".frag");
 
@@ -1247,7 +2390,30 @@ Renderer::BlurProgram::BlurProgram() {
   glDetachShader(program, vertex_shader.id);
   glDetachShader(program, fragment_shader.id);
   color_texture = glGetUniformLocation(program, "color_texture");
-  horizontal = glGetUniformLocation(program, "horizontal");
+  uv_scale = glGetUniformLocation(program, "uv_scale");
+}
+
+Renderer::BloomUpsampleProgram::BloomUpsampleProgram() {
+  std::string name = "bloom_upsample";
+  // Same full screen pass as the downsample.
+  auto vert_source = text("assets/shaders/bloom_downsample.vert");
+  auto frag_source = text("assets/shaders/" + name + ".frag");
+
+  const auto vertex_shader = Shader(vert_source, GL_VERTEX_SHADER, name);
+  const auto fragment_shader = Shader(frag_source, GL_FRAGMENT_SHADER, name);
+
+  glAttachShader(program, vertex_shader.id);
+  glAttachShader(program, fragment_shader.id);
+  glBindAttribLocation(program, 0, "position");
+  glBindAttribLocation(program, 1, "uv");
+  link(name);
+  check(name);
+
+  glDetachShader(program, vertex_shader.id);
+  glDetachShader(program, fragment_shader.id);
+  color_texture = glGetUniformLocation(program, "color_texture");
+  radius = glGetUniformLocation(program, "radius");
+  uv_scale = glGetUniformLocation(program, "uv_scale");
 }
 
 Renderer::PropagateProgram::PropagateProgram() {
@@ -1412,19 +2578,19 @@ Renderer::EnvironmentMapTarget::~EnvironmentMapTarget() {
   glDeleteFramebuffers(1, &frame_buffer);
 }
 
-Renderer::StandardTarget::StandardTarget(const glm::ivec2 &resolution) {
+Renderer::StandardTarget::StandardTarget(const glm::ivec2 &resolution) : resolution(resolution) {
   glGenFramebuffers(1, &frame_buffer);
   glBindFramebuffer(GL_FRAMEBUFFER, frame_buffer);
 
   glGenTextures(1, &texture);
   glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, texture);
-  glTexImage2DMultisample(GL_TEXTURE_2D_MULTISAMPLE, 4, GL_RGBA16F, resolution.x, resolution.y, GL_TRUE);
+  glTexImage2DMultisample(GL_TEXTURE_2D_MULTISAMPLE, samples, GL_RGBA16F, resolution.x, resolution.y, GL_TRUE);
   glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, 0);
   glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D_MULTISAMPLE, texture, 0);
 
   glGenTextures(1, &depth_texture);
   glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, depth_texture);
-  glTexStorage2DMultisample(GL_TEXTURE_2D_MULTISAMPLE, 4, GL_DEPTH_COMPONENT24, resolution.x, resolution.y, true);
+  glTexStorage2DMultisample(GL_TEXTURE_2D_MULTISAMPLE, samples, GL_DEPTH_COMPONENT24, resolution.x, resolution.y, true);
   glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, 0);
   glFramebufferTexture2D(GL_FRAMEBUFFER,
                          GL_DEPTH_ATTACHMENT,
@@ -1479,30 +2645,74 @@ Renderer::MultiTarget::~MultiTarget() {
   glDeleteTextures(1, &color_texture);
   glDeleteTextures(1, &bright_texture);
 }
-Renderer::BlurTarget::BlurTarget(const glm::ivec2 &resolution) {
+Renderer::OffscreenTarget::OffscreenTarget(const glm::ivec2 &resolution)
+    : fences{nullptr, nullptr}, index(0), resolution(resolution) {
   glGenFramebuffers(1, &frame_buffer);
   glBindFramebuffer(GL_FRAMEBUFFER, frame_buffer);
 
   glGenTextures(1, &texture);
   glBindTexture(GL_TEXTURE_2D, texture);
-  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB16F, resolution.x, resolution.y, 0, GL_RGB, GL_FLOAT, NULL);
+  glTexStorage2D(GL_TEXTURE_2D, 1, GL_SRGB8_ALPHA8, resolution.x, resolution.y);
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
   glBindTexture(GL_TEXTURE_2D, 0);
   glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
 
   if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
-    throw std::runtime_error("Framebuffer incomplete");
+    throw std::runtime_error("Offscreen framebuffer incomplete.");
   }
   glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
+  glGenBuffers(GLsizei(pixel_buffers.size()), pixel_buffers.data());
+  for (auto pixel_buffer : pixel_buffers) {
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, pixel_buffer);
+    glBufferData(GL_PIXEL_PACK_BUFFER, GLsizeiptr(resolution.x) * resolution.y * 4, nullptr, GL_STREAM_READ);
+  }
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
 }
-Renderer::BlurTarget::~BlurTarget() {
+
+Renderer::OffscreenTarget::~OffscreenTarget() {
+  for (auto fence : fences) {
+    if (fence) {
+      glDeleteSync(fence);
+    }
+  }
+  glDeleteBuffers(GLsizei(pixel_buffers.size()), pixel_buffers.data());
   glDeleteFramebuffers(1, &frame_buffer);
   glDeleteTextures(1, &texture);
 }
+
+Renderer::BloomTarget::BloomTarget(const glm::ivec2 &resolution) {
+  glGenFramebuffers(1, &frame_buffer);
+  glBindFramebuffer(GL_FRAMEBUFFER, frame_buffer);
+
+  auto level_resolution = glm::max(resolution / 2, glm::ivec2(1));
+  do {
+    GLuint texture;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexStorage2D(GL_TEXTURE_2D, 1, GL_R11F_G11F_B10F, level_resolution.x, level_resolution.y);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    textures.push_back(texture);
+    resolutions.push_back(level_resolution);
+    level_resolution = glm::max(level_resolution / 2, glm::ivec2(1));
+  } while (textures.size() < 6 && glm::min(level_resolution.x, level_resolution.y) >= 8);
+  glBindTexture(GL_TEXTURE_2D, 0);
+
+  glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, textures[0], 0);
+  if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+    throw std::runtime_error("Framebuffer incomplete");
+  }
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+Renderer::BloomTarget::~BloomTarget() {
+  glDeleteFramebuffers(1, &frame_buffer);
+  glDeleteTextures(GLsizei(textures.size()), textures.data());
+}
 Renderer::Quad::Quad() {
   static const float quad_vertices[] = {
       -1.0f, 1.0f, 0.0f, 1.0f,
@@ -1566,6 +2776,46 @@ Renderer::Box::Box() {
 }
 Renderer::Box::~Box() {
 
+}
+Renderer::TextBatch::TextBatch() : capacity(0) {
+  glGenVertexArrays(1, &vertex_array);
+  glGenBuffers(1, &buffer);
+  glGenBuffers(1, &element_buffer);
+  glBindVertexArray(vertex_array);
+  glBindBuffer(GL_ARRAY_BUFFER, buffer);
+  glEnableVertexAttribArray(0);
+  glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(GlyphVertex),
+                        reinterpret_cast<const void *>(offsetof(GlyphVertex, position)));
+  glEnableVertexAttribArray(1);
+  glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(GlyphVertex),
+                        reinterpret_cast<const void *>(offsetof(GlyphVertex, uv)));
+  glEnableVertexAttribArray(2);
+  glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(GlyphVertex),
+                        reinterpret_cast<const void *>(offsetof(GlyphVertex, color)));
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, element_buffer);
+  glBindVertexArray(0);
+}
+Renderer::TextBatch::~TextBatch() {
+  glDeleteBuffers(1, &buffer);
+  glDeleteBuffers(1, &element_buffer);
+  glDeleteVertexArrays(1, &vertex_array);
+}
+void Renderer::TextBatch::reserve(const size_t quads) {
+  if (quads <= capacity) {
+    return;
+  }
+  capacity = std::max(quads, capacity * 2);
+  // Same two triangles per quad as Text lays out.
+  std::vector<GLuint> indices;
+  indices.reserve(capacity * 6);
+  for (GLuint quad = 0; quad < capacity; quad++) {
+    const GLuint vertex = quad * 4;
+    indices.insert(indices.end(), {vertex, vertex + 1, vertex + 2, vertex, vertex + 3, vertex + 1});
+  }
+  glBindVertexArray(vertex_array);
+  glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), indices.data(), GL_STATIC_DRAW);
+  glBindVertexArray(0);
 }
 Renderer::TextureBuffer2D::TextureBuffer2D(const GLuint internal_format,
                                            const GLuint external_format,
@@ -1574,7 +2824,16 @@ Renderer::TextureBuffer2D::TextureBuffer2D(const GLuint internal_format,
                                            const GLuint wrap,
                                            const void *data,
                                            const bool mipmaps,
-                                           const TimePoint &modified) : modified(modified) {
+                                           const TimePoint &modified) :
+    modified(modified),
+    format(Texture::Format::RGBA),
+    width(width),
+    height(height),
+    levels(1),
+    base_level(0),
+    wanted_level(0),
+    requested(false),
+    bytes(0) {
   glGenTextures(1, &texture);
   glBindTexture(GL_TEXTURE_2D, texture);
 
@@ -1593,17 +2852,182 @@ Renderer::TextureBuffer2D::TextureBuffer2D(const GLuint internal_format,
     glGenerateMipmap(GL_TEXTURE_2D);
   };
   glBindTexture(GL_TEXTURE_2D, 0);
+  bytes = resident_size(mipmaps);
 }
 Renderer::TextureBuffer2D::~TextureBuffer2D() {
   glDeleteTextures(1, &texture);
 }
-Renderer::TextureBuffer2D::TextureBuffer2D(const Texture2D &texture_2d) :
-    TextureBuffer2D(format_convert(texture_2d.format).internal_format, format_convert(texture_2d.format).format,
-                    texture_2d.width(),
-                    texture_2d.height(),
-                    wrap_convert(texture_2d.wrap),
-                    texture_2d.layers[0].data(),
-                    texture_2d.mipmaps) {}
+Renderer::TextureBuffer2D::TextureBuffer2D(const Texture2D &texture_2d, const int base_level) :
+    TextureBuffer2D(texture_2d, create_texture(texture_2d, base_level), base_level) {}
+
+Renderer::TextureBuffer2D::TextureBuffer2D(const Texture2D &texture_2d, const GLuint texture, const int base_level) :
+    texture(texture),
+    modified(std::chrono::system_clock::now()),
+    format(texture_2d.format),
+    width(texture_2d.width()),
+    height(texture_2d.height()),
+    levels(texture_2d.levels),
+    base_level(base_level),
+    wanted_level(texture_2d.levels - 1),
+    requested(false),
+    bytes(resident_size(texture_2d.mipmaps)) {}
+
+size_t Renderer::TextureBuffer2D::level_size(const int level) const {
+  return Texture::size(format, std::max(1, width >> level), std::max(1, height >> level));
+}
+
+size_t Renderer::TextureBuffer2D::resident_size(const bool mipmaps) const {
+  size_t size = 0;
+  for (int level = base_level; level < levels; level++) {
+    size += level_size(level);
+  }
+  // Generated mips add a third.
+  return levels == 1 && mipmaps ? size * 4 / 3 : size;
+}
+
+void Renderer::TextureBuffer2D::request(const int level) {
+  wanted_level = requested ? std::min(wanted_level, level) : level;
+  requested = true;
+}
+
+void Renderer::TextureBuffer2D::stream_in(const Texture2D &texture_2d) {
+  const int level = base_level - 1;
+  glBindTexture(GL_TEXTURE_2D, texture);
+  upload_texture_level(texture_2d, level, level_data(texture_2d, level));
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level);
+  glBindTexture(GL_TEXTURE_2D, 0);
+  base_level = level;
+  bytes += level_size(level);
+}
+
+void Renderer::TextureBuffer2D::stream_out() {
+  const int level = base_level;
+  glBindTexture(GL_TEXTURE_2D, texture);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level + 1);
+  // Respecify the level as empty, to release its memory.
+  const auto internal_format = format_convert(format).internal_format;
+  if (Texture::compressed(format)) {
+    glCompressedTexImage2D(GL_TEXTURE_2D, level, internal_format, 0, 0, 0, 0, nullptr);
+  } else {
+    glTexImage2D(GL_TEXTURE_2D, level, internal_format, 0, 0, 0,
+                 format_convert(format).format, GL_UNSIGNED_BYTE, nullptr);
+  }
+  glBindTexture(GL_TEXTURE_2D, 0);
+  base_level = level + 1;
+  bytes -= level_size(level);
+}
+
+void Renderer::Upload::release() {
+  glDeleteBuffers(1, &array_buffer);
+  glDeleteBuffers(1, &element_array_buffer);
+  glDeleteTextures(1, &texture_buffer);
+  glDeleteSync(fence);
+}
+
+Renderer::UploadQueue::UploadQueue(const std::function<void(bool)> &make_current)
+    : stop_(false), thread_(&UploadQueue::run, this, make_current) {}
+
+Renderer::UploadQueue::~UploadQueue() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  condition_.notify_one();
+  thread_.join();
+  for (auto &upload : done_) {
+    upload.release();
+  }
+}
+
+void Renderer::UploadQueue::push(Upload upload) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    queued_.push_back(std::move(upload));
+  }
+  condition_.notify_one();
+}
+
+std::vector<Renderer::Upload> Renderer::UploadQueue::poll() {
+  std::vector<Upload> uploads;
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (error_) {
+    std::rethrow_exception(std::exchange(error_, nullptr));
+  }
+  // Fences of one context signal in order.
+  while (!done_.empty()) {
+    const auto status = glClientWaitSync(done_.front().fence, 0, 0);
+    if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) {
+      break;
+    }
+    glDeleteSync(done_.front().fence);
+    done_.front().fence = nullptr;
+    uploads.push_back(std::move(done_.front()));
+    done_.pop_front();
+  }
+  return uploads;
+}
+
+void Renderer::UploadQueue::run(const std::function<void(bool)> make_current) {
+  // Exceptions can not leave the thread, they are handed to poll().
+  try {
+    make_current(true);
+  } catch (...) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    error_ = std::current_exception();
+    return;
+  }
+  try {
+    process();
+  } catch (...) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    error_ = std::current_exception();
+  }
+  // The context is destroyed with its window, not current on a finished thread.
+  make_current(false);
+}
+
+void Renderer::UploadQueue::process() {
+  while (true) {
+    Upload upload;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      condition_.wait(lock, [&] { return stop_ || !queued_.empty(); });
+      if (stop_) {
+        return;
+      }
+      upload = std::move(queued_.front());
+      queued_.pop_front();
+    }
+    if (upload.mesh) {
+      const auto &mesh = *upload.mesh;
+      const MeshBounds bounds(mesh);
+      std::vector<unsigned char> packed;
+      upload.array_buffer = create_buffer(vertex_data(mesh, upload.layout, bounds.min, bounds.max, packed),
+                                          mesh.vertices.size() * upload.layout.stride());
+      upload.element_array_buffer = create_buffer(mesh.triangles.data(),
+                                                  mesh.triangles.size() * 3 * sizeof(unsigned int));
+    } else {
+      const auto &texture = *upload.texture;
+      const auto &data = texture.layers[0];
+      if (data.empty()) {
+        upload.texture_buffer = create_texture(texture, upload.base_level);
+      } else {
+        // Copy to a pixel unpack buffer, the driver transfers from there.
+        const size_t offset = texture.offset(upload.base_level);
+        const GLuint pixel_buffer = create_buffer(data.data() + offset, data.size() - offset);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pixel_buffer);
+        upload.texture_buffer = create_texture(texture, upload.base_level, true);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        // Freed by GL once the transfer is done.
+        glDeleteBuffers(1, &pixel_buffer);
+      }
+    }
+    upload.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    glFlush();
+    std::lock_guard<std::mutex> lock(mutex_);
+    done_.push_back(std::move(upload));
+  }
+}
 
 Renderer::Shader::Shader(const std::string &source,
                          const GLuint type,
@@ -1612,7 +3036,8 @@ Renderer::Shader::Shader(const std::string &source,
   static const std::map<const unsigned int, std::string> shader_types{
       {GL_VERTEX_SHADER, "vertex shader"},
       {GL_FRAGMENT_SHADER, "fragment shader"},
-      {GL_GEOMETRY_SHADER, "geometry shader"}};
+      {GL_GEOMETRY_SHADER, "geometry shader"},
+      {GL_COMPUTE_SHADER, "compute shader"}};
 
   auto const *chars = source.c_str();
   id = glCreateShader(type);
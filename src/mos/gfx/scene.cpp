@@ -1,7 +1,7 @@
 #include <mos/gfx/scene.hpp>
 namespace mos {
 namespace gfx {
-Scene::Scene(){}
+Scene::Scene() : depth_prepass(DepthPrepass::OFF), occlusion_culling(false) {}
 
 Scene::Scene(const Models &models,
              const Camera &camera,
@@ -14,6 +14,8 @@ Scene::Scene(const Models &models,
       lights(lights),
       environment_lights(environment_lights),
       fog(fog),
-      boxes(boxes){}
+      boxes(boxes),
+      depth_prepass(DepthPrepass::OFF),
+      occlusion_culling(false) {}
 }
 }
@@ -0,0 +1,34 @@
+#include <mos/gfx/scene_view.hpp>
+
+namespace mos {
+namespace gfx {
+
+SceneView::SceneView() : depth_prepass(Scene::DepthPrepass::OFF), occlusion_culling(false) {}
+
+SceneView::SceneView(const Scene &scene)
+    : models(scene.models),
+      particle_clouds(scene.particle_clouds),
+      boxes(scene.boxes),
+      texture_targets(scene.texture_targets),
+      texts(scene.texts),
+      lights(scene.lights),
+      camera(scene.camera),
+      fog(scene.fog),
+      environment_lights(scene.environment_lights),
+      depth_prepass(scene.depth_prepass),
+      occlusion_culling(scene.occlusion_culling) {}
+
+SceneView::SceneView(Span<const Model> models,
+                     const Camera &camera,
+                     const Lights &lights,
+                     const Fog &fog,
+                     const EnvironmentLights &environment_lights)
+    : models(models),
+      lights(lights),
+      camera(camera),
+      fog(fog),
+      environment_lights(environment_lights),
+      depth_prepass(Scene::DepthPrepass::OFF),
+      occlusion_culling(false) {}
+}
+}
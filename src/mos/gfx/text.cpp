@@ -13,6 +13,13 @@ Text::Text(const std::string &txt,
            const glm::mat4 &transform,
            const bool emiss,
            const float spacing)
+    : Text(txt, std::make_shared<Font>(font), transform, emiss, spacing) {}
+
+Text::Text(const std::string &txt,
+           const SharedFont &font,
+           const glm::mat4 &transform,
+           const bool emiss,
+           const float spacing)
     : model_("Text", std::make_shared<Mesh>(Mesh()),
              transform),
       font_(font), spacing(spacing) {
@@ -30,54 +37,53 @@ std::string Text::text() const { return text_; }
 void Text::text(const std::string &text) {
   if (text_.compare(text) != 0) {
     text_ = text;
-    std::vector<std::string> lines = mos::split(text_, '\n');
-    model_.mesh->clear();
-
-    float line_index = 0.0f;
-    const float line_height = -1.0f;
-    int triangle_index = 0;
-    for (auto &line : lines) {
-      float index = 0.0f;
-      for (auto &c : line) {
-        auto character = font_.characters.at(c);
-        float u1 = character.x / ((float) font_.texture->width());
-        float u2 = (character.x + character.width) /
-            (float) font_.texture->width();
-        float v1 = character.y / ((float) font_.texture->height());
-        float v2 = ((character.y + character.height) /
-            ((float) font_.texture->height()));
-
-        float offset_y = -(character.y_offset - font_.base()) / font_.height();
-        float offset_x = character.x_offset / font_.height();
-        float rect_h = -character.height / font_.height();
-        float rect_w = character.width / font_.height();
-        float advance = character.x_advance / font_.height();
-
-        float z = index / 2000.0f;
-
-        model_.mesh->vertices.push_back(
-            Vertex(glm::vec3(index + offset_x, rect_h + offset_y + line_index, z),
-                   glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f), glm::vec2(u1, v2)));
-
-        model_.mesh->vertices.push_back(Vertex(
-            glm::vec3(index + rect_w + offset_x, offset_y + line_index, z),
-            glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f), glm::vec2(u2, v1)));
-
-        model_.mesh->vertices.push_back(Vertex(glm::vec3(index + offset_x, offset_y + line_index, z),
-                                               glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f), glm::vec2(u1, v1)));
-
-        model_.mesh->triangles.push_back({triangle_index++, triangle_index++, triangle_index++});
-
-        model_.mesh->vertices.push_back(Vertex(glm::vec3(index + rect_w + offset_x,
-                                                         rect_h + offset_y + line_index, z),
-                                               glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f), glm::vec2(u2, v2)));
-
-        model_.mesh->triangles.push_back({triangle_index - 3, triangle_index++, triangle_index - 3});
-
-        index += advance + spacing;
-      }
+    layout();
+  }
+}
+
+void Text::layout() {
+  size_t count = 0;
+  for (const char c : text_) {
+    count += font_->glyph(c).valid ? 1 : 0;
+  }
+  // Shrinking keeps the capacity, so relayout of similar text does not allocate.
+  auto &mesh = *model_.mesh;
+  mesh.vertices.resize(count * 4);
+  mesh.triangles.resize(count * 2);
+  auto *vertices = mesh.vertices.data();
+  auto *triangles = mesh.triangles.data();
+
+  const glm::vec3 normal(0.0f, 0.0f, 1.0f);
+  const float line_height = -1.0f;
+  float line_index = 0.0f;
+  float index = 0.0f;
+  int vertex = 0;
+  for (const char c : text_) {
+    if (c == '\n') {
       line_index += line_height;
+      index = 0.0f;
+      continue;
     }
+    const auto &glyph = font_->glyph(c);
+    if (!glyph.valid) {
+      continue;
+    }
+    const float x = index + glyph.offset.x;
+    const float y = glyph.offset.y + line_index;
+    const float z = index / 2000.0f;
+
+    *vertices++ = Vertex(glm::vec3(x, y + glyph.size.y, z), normal, glm::vec3(0.0f),
+                         glm::vec2(glyph.uv_min.x, glyph.uv_max.y));
+    *vertices++ = Vertex(glm::vec3(x + glyph.size.x, y, z), normal, glm::vec3(0.0f),
+                         glm::vec2(glyph.uv_max.x, glyph.uv_min.y));
+    *vertices++ = Vertex(glm::vec3(x, y, z), normal, glm::vec3(0.0f), glyph.uv_min);
+    *vertices++ = Vertex(glm::vec3(x + glyph.size.x, y + glyph.size.y, z), normal, glm::vec3(0.0f),
+                         glyph.uv_max);
+    *triangles++ = Triangle{vertex, vertex + 1, vertex + 2};
+    *triangles++ = Triangle{vertex, vertex + 3, vertex + 1};
+    vertex += 4;
+
+    index += glyph.advance + spacing;
   }
 }
 
@@ -133,7 +139,15 @@ glm::mat4 Text::transform() const {
   return model_.transform;
 }
 
-Model Text::model() const { return model_; }
+const Model &Text::model() const { return model_; }
+
+glm::vec4 Text::color() const {
+  const auto &material = model_.material;
+  const auto color = material.emission_map
+                     ? material.emission * material.emission_strength
+                     : material.albedo;
+  return glm::vec4(color * material.factor, material.opacity);
+}
 
 Text &Text::operator=(const std::string &input) {
   text(input);
@@ -146,11 +160,11 @@ Text &Text::operator+=(const std::string &input) {
 }
 void Text::emissive(const bool emissive) {
   if (emissive) {
-    model_.material.emission_map = font_.texture;
+    model_.material.emission_map = font_->texture;
     model_.material.emission_strength = 1.0f;
     model_.material.albedo_map = nullptr;
   } else {
-    model_.material.albedo_map = font_.texture;
+    model_.material.albedo_map = font_->texture;
     model_.material.emission_map = nullptr;
   }
 }
@@ -163,8 +177,8 @@ void Text::opacity(const float &opacity) {
 void Text::emission_strength(const float strength) {
   model_.material.emission_strength = strength;
 }
-Font Text::font() const {
-  return font_;
+const Font &Text::font() const {
+  return *font_;
 }
 }
 }
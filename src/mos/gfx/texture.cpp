@@ -1,11 +1,50 @@
 #include <mos/gfx/texture.hpp>
+#include <mos/core/mapped_file.hpp>
 #include <stdexcept>
+#include <fstream>
+#include <algorithm>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <limits>
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
 #include <map>
 
 namespace mos {
 namespace gfx {
+
+namespace {
+/**
+ * Header of the *.texture container. It is followed by an index with the
+ * offset and size of each level of each layer, and then the level data.
+ * Levels are copied into the layers when loaded.
+ */
+struct ContainerHeader {
+  char magic[4];
+  uint32_t version;
+  uint32_t format;
+  uint32_t width;
+  uint32_t height;
+  uint32_t levels;
+  uint32_t layers;
+  uint32_t reserved;
+};
+
+struct ContainerLevel {
+  uint64_t offset;
+  uint64_t size;
+};
+
+const char container_magic[4] = {'M', 'O', 'S', 'T'};
+const uint32_t container_version = 2;
+const uint64_t container_alignment = 16;
+
+uint64_t align(const uint64_t offset) {
+  return (offset + container_alignment - 1) / container_alignment * container_alignment;
+}
+}
+
 std::atomic_uint Texture::current_id_;
 Texture::Texture(const int width,
                  const int height,
@@ -17,6 +56,7 @@ Texture::Texture(const int width,
                                        format(format),
                                        wrap(wrap),
                                        mipmaps(mipmaps),
+                                       levels(1),
                                        layers{Data()} {}
 
 Texture::Texture(const std::initializer_list<Texture::Data> &layers,
@@ -24,27 +64,57 @@ Texture::Texture(const std::initializer_list<Texture::Data> &layers,
                  const int height,
                  const Texture::Format &format,
                  const Texture::Wrap &wrap,
-                 const bool mipmaps) : Texture(layers.begin(),
-                                               layers.end(),
-                                               width,
-                                               height,
-                                               format,
-                                               wrap,
-                                               mipmaps) {}
+                 const bool mipmaps,
+                 const int levels) : Texture(layers.begin(),
+                                             layers.end(),
+                                             width,
+                                             height,
+                                             format,
+                                             wrap,
+                                             mipmaps,
+                                             levels) {}
 
 Texture::Texture(const std::initializer_list<std::string> &paths,
                  const bool color_data,
                  const Texture::Wrap &wrap,
-                 const bool mipmaps) : id_(current_id_++), wrap(wrap), mipmaps(mipmaps) {
+                 const bool mipmaps) : id_(current_id_++), wrap(wrap), mipmaps(mipmaps), levels(1) {
   for (auto &path : paths) {
+    if (path.size() > 8 && path.substr(path.size() - 8) == ".texture") {
+      load_container(path);
+      continue;
+    }
     int bpp;
     unsigned char *pixels = stbi_load(path.c_str(), &width_, &height_, &bpp, 0);
     layers.push_back(Data(pixels, pixels + (width_ * height_ * bpp)));
+    stbi_image_free(pixels);
     std::map<int, Format> bpp_map{{1, Format::R}, {2, Format::RG}, {3, color_data ? Format::SRGB : Format::RGB}, {4, color_data ? Format::SRGBA : Format::RGBA}};
     format = bpp_map[bpp];
   }
 }
 
+bool Texture::compressed(const Format &format) {
+  return format >= Format::BC1;
+}
+
+bool Texture::alpha(const Format &format) {
+  return format == Format::RGBA || format == Format::SRGBA ||
+         format == Format::BC3 || format == Format::BC3_SRGB ||
+         format == Format::BC7 || format == Format::BC7_SRGB;
+}
+
+size_t Texture::size(const Format &format, const int width, const int height) {
+  static const std::map<Format, size_t> bytes{
+      {Format::R, 1}, {Format::RG, 2}, {Format::RGB, 3}, {Format::RGBA, 4},
+      {Format::SRGB, 3}, {Format::SRGBA, 4},
+      {Format::BC1, 8}, {Format::BC1_SRGB, 8}, {Format::BC4, 8},
+      {Format::BC3, 16}, {Format::BC3_SRGB, 16}, {Format::BC5, 16},
+      {Format::BC7, 16}, {Format::BC7_SRGB, 16}};
+  if (compressed(format)) {
+    return size_t((width + 3) / 4) * size_t((height + 3) / 4) * bytes.at(format);
+  }
+  return size_t(width) * size_t(height) * bytes.at(format);
+}
+
 int Texture::id() const {
   return id_;
 }
@@ -58,5 +128,115 @@ int Texture::depth() const {
   return layers.size();
 }
 
+int Texture::width(const int level) const {
+  return std::max(1, width_ >> level);
+}
+
+int Texture::height(const int level) const {
+  return std::max(1, height_ >> level);
+}
+
+size_t Texture::offset(const int level) const {
+  size_t offset = 0;
+  for (int i = 0; i < level; i++) {
+    offset += size(format, width(i), height(i));
+  }
+  return offset;
+}
+
+void Texture::save(const std::string &path) const {
+  std::ofstream file(path, std::ios::binary);
+  if (!file) {
+    throw std::runtime_error("Could not write " + path);
+  }
+  ContainerHeader header{};
+  std::memcpy(header.magic, container_magic, sizeof(header.magic));
+  header.version = container_version;
+  header.format = uint32_t(format);
+  header.width = uint32_t(width_);
+  header.height = uint32_t(height_);
+  header.levels = uint32_t(levels);
+  header.layers = uint32_t(layers.size());
+
+  std::vector<ContainerLevel> index;
+  uint64_t position = align(sizeof(header) + sizeof(ContainerLevel) * levels * layers.size());
+  for (const auto &layer : layers) {
+    if (layer.size() != offset(levels)) {
+      throw std::runtime_error("Texture layer does not match its levels, can not write " + path);
+    }
+    for (int level = 0; level < levels; level++) {
+      const auto level_size = size(format, width(level), height(level));
+      index.push_back(ContainerLevel{position, level_size});
+      position = align(position + level_size);
+    }
+  }
+
+  file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  file.write(reinterpret_cast<const char *>(index.data()), sizeof(ContainerLevel) * index.size());
+  const std::vector<char> padding(container_alignment, 0);
+  auto entry = index.begin();
+  for (const auto &layer : layers) {
+    for (int level = 0; level < levels; level++, entry++) {
+      file.write(padding.data(), std::streamsize(entry->offset) - std::streamsize(file.tellp()));
+      file.write(reinterpret_cast<const char *>(layer.data() + offset(level)), entry->size);
+    }
+  }
+}
+
+void Texture::load_container(const std::string &path) {
+  const MappedFile file(path);
+  ContainerHeader header{};
+  if (file.size() < sizeof(header)) {
+    throw std::runtime_error(path + " is not a texture container.");
+  }
+  std::memcpy(&header, file.data(), sizeof(header));
+  if (std::memcmp(header.magic, container_magic, sizeof(header.magic)) != 0) {
+    throw std::runtime_error(path + " is not a texture container.");
+  }
+  if (header.version != container_version || header.format > uint32_t(Format::BC7_SRGB)) {
+    throw std::runtime_error(path + " has an unsupported texture container version or format.");
+  }
+  if (header.width == 0 || header.height == 0 || header.levels == 0 || header.layers == 0) {
+    throw std::runtime_error(path + " has an empty texture.");
+  }
+  if (header.width > uint32_t(std::numeric_limits<int>::max())
+      || header.height > uint32_t(std::numeric_limits<int>::max())) {
+    throw std::runtime_error(path + " has an unsupported texture size.");
+  }
+  // Levels halve down to 1x1, more would shift past the width of int.
+  uint32_t chain = 1;
+  for (auto extent = std::max(header.width, header.height); extent > 1; extent >>= 1) {
+    chain++;
+  }
+  if (header.levels > chain) {
+    throw std::runtime_error(path + " has more levels than its size allows.");
+  }
+  const size_t entries = size_t(header.levels) * header.layers;
+  if (file.size() < sizeof(header) + entries * sizeof(ContainerLevel)) {
+    throw std::runtime_error(path + " is truncated.");
+  }
+  format = Format(header.format);
+  width_ = int(header.width);
+  height_ = int(header.height);
+  levels = int(header.levels);
+  mipmaps = levels > 1;
+
+  std::vector<ContainerLevel> index(entries);
+  std::memcpy(index.data(), file.data() + sizeof(header), entries * sizeof(ContainerLevel));
+  auto entry = index.begin();
+  for (uint32_t i = 0; i < header.layers; i++) {
+    Data data;
+    data.reserve(offset(levels));
+    for (int level = 0; level < levels; level++, entry++) {
+      if (entry->size != size(format, width(level), height(level))
+          || entry->offset > file.size() || entry->size > file.size() - entry->offset) {
+        throw std::runtime_error(path + " has an invalid level " + std::to_string(level) + ".");
+      }
+      data.insert(data.end(), file.data() + entry->offset, file.data() + entry->offset + entry->size);
+    }
+    layers.push_back(data);
+  }
+}
+
 }
 }
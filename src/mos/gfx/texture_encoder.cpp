@@ -0,0 +1,392 @@
+#include <mos/gfx/texture_encoder.hpp>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <cstdint>
+#include <stdexcept>
+#include <algorithm>
+#include <glm/glm.hpp>
+
+namespace mos {
+namespace gfx {
+
+namespace {
+
+/** 4x4 texels, RGBA in the 0-255 range. */
+using Block = std::array<glm::vec4, 16>;
+
+Block load_block(const Texture::Data &rgba, const int width, const int height, const int block_x, const int block_y) {
+  Block block;
+  for (int y = 0; y < 4; y++) {
+    for (int x = 0; x < 4; x++) {
+      // Edge blocks repeat the last row and column.
+      const int source_x = std::min(block_x * 4 + x, width - 1);
+      const int source_y = std::min(block_y * 4 + y, height - 1);
+      const auto *pixel = &rgba[(size_t(source_y) * width + source_x) * 4];
+      block[y * 4 + x] = glm::vec4(pixel[0], pixel[1], pixel[2], pixel[3]);
+    }
+  }
+  return block;
+}
+
+/** Line through the texels along their principal axis, masked to the channels used. */
+void fit_endpoints(const Block &block, const glm::vec4 &mask, glm::vec4 &low, glm::vec4 &high) {
+  glm::vec4 mean(0.0f);
+  for (const auto &texel : block) {
+    mean += texel * mask;
+  }
+  mean /= float(block.size());
+
+  float covariance[4][4] = {};
+  for (const auto &texel : block) {
+    const glm::vec4 d = (texel * mask) - mean;
+    for (int i = 0; i < 4; i++) {
+      for (int j = 0; j < 4; j++) {
+        covariance[i][j] += d[i] * d[j];
+      }
+    }
+  }
+
+  // Power iteration.
+  glm::vec4 axis = mask;
+  for (int iteration = 0; iteration < 8; iteration++) {
+    glm::vec4 next(0.0f);
+    for (int i = 0; i < 4; i++) {
+      for (int j = 0; j < 4; j++) {
+        next[i] += covariance[i][j] * axis[j];
+      }
+    }
+    const float length = glm::length(next);
+    if (length < 1e-6f) {
+      low = high = mean;
+      return;
+    }
+    axis = next / length;
+  }
+
+  float min = std::numeric_limits<float>::max();
+  float max = std::numeric_limits<float>::lowest();
+  for (const auto &texel : block) {
+    const float t = glm::dot((texel * mask) - mean, axis);
+    min = std::min(min, t);
+    max = std::max(max, t);
+  }
+  // Inset, so the endpoints are not pulled out by outliers.
+  const float inset = (max - min) / 16.0f;
+  low = glm::clamp(mean + axis * (min + inset), glm::vec4(0.0f), glm::vec4(255.0f));
+  high = glm::clamp(mean + axis * (max - inset), glm::vec4(0.0f), glm::vec4(255.0f));
+}
+
+float distance2(const glm::vec4 &a, const glm::vec4 &b) {
+  const glm::vec4 d = a - b;
+  return glm::dot(d, d);
+}
+
+uint16_t to_565(const glm::vec4 &color) {
+  const auto r = uint16_t(std::lround(color.r * 31.0f / 255.0f));
+  const auto g = uint16_t(std::lround(color.g * 63.0f / 255.0f));
+  const auto b = uint16_t(std::lround(color.b * 31.0f / 255.0f));
+  return uint16_t((r << 11) | (g << 5) | b);
+}
+
+glm::vec4 from_565(const uint16_t color) {
+  const int r = (color >> 11) & 31;
+  const int g = (color >> 5) & 63;
+  const int b = color & 31;
+  return glm::vec4((r << 3) | (r >> 2), (g << 2) | (g >> 4), (b << 3) | (b >> 2), 0.0f);
+}
+
+/** BC1 colour block, always in four colour mode. */
+void encode_bc1(const Block &block, unsigned char *out) {
+  const glm::vec4 mask(1.0f, 1.0f, 1.0f, 0.0f);
+  glm::vec4 low, high;
+  fit_endpoints(block, mask, low, high);
+  uint16_t color0 = to_565(high);
+  uint16_t color1 = to_565(low);
+  if (color0 < color1) {
+    std::swap(color0, color1);
+  }
+
+  uint32_t indices = 0;
+  if (color0 != color1) {
+    const glm::vec4 c0 = from_565(color0);
+    const glm::vec4 c1 = from_565(color1);
+    const std::array<glm::vec4, 4> palette{c0, c1, (2.0f * c0 + c1) / 3.0f, (c0 + 2.0f * c1) / 3.0f};
+    for (size_t i = 0; i < block.size(); i++) {
+      uint32_t best = 0;
+      float best_distance = std::numeric_limits<float>::max();
+      for (uint32_t p = 0; p < palette.size(); p++) {
+        const float d = distance2(block[i] * mask, palette[p]);
+        if (d < best_distance) {
+          best_distance = d;
+          best = p;
+        }
+      }
+      indices |= best << (2 * i);
+    }
+  }
+
+  out[0] = uint8_t(color0 & 0xff);
+  out[1] = uint8_t(color0 >> 8);
+  out[2] = uint8_t(color1 & 0xff);
+  out[3] = uint8_t(color1 >> 8);
+  for (int i = 0; i < 4; i++) {
+    out[4 + i] = uint8_t((indices >> (8 * i)) & 0xff);
+  }
+}
+
+/** BC4 block of one channel, in eight value mode. */
+void encode_bc4(const Block &block, const int channel, unsigned char *out) {
+  float min = 255.0f;
+  float max = 0.0f;
+  for (const auto &texel : block) {
+    min = std::min(min, texel[channel]);
+    max = std::max(max, texel[channel]);
+  }
+  const auto value0 = uint8_t(std::lround(max));
+  const auto value1 = uint8_t(std::lround(min));
+
+  uint64_t indices = 0;
+  if (value0 != value1) {
+    for (size_t i = 0; i < block.size(); i++) {
+      // Steps from value0 towards value1, index 1 is value1 and 2-7 are in between.
+      const auto step = std::lround((value0 - block[i][channel]) / float(value0 - value1) * 7.0f);
+      const uint64_t index = step == 0 ? 0 : step == 7 ? 1 : uint64_t(step + 1);
+      indices |= index << (3 * i);
+    }
+  }
+
+  out[0] = value0;
+  out[1] = value1;
+  for (int i = 0; i < 6; i++) {
+    out[2 + i] = uint8_t((indices >> (8 * i)) & 0xff);
+  }
+}
+
+class BitWriter {
+public:
+  explicit BitWriter(unsigned char *out) : out_(out), position_(0) {
+    std::fill(out_, out_ + 16, 0);
+  }
+  void write(const uint32_t value, const int bits) {
+    for (int i = 0; i < bits; i++, position_++) {
+      if ((value >> i) & 1) {
+        out_[position_ / 8] |= uint8_t(1 << (position_ % 8));
+      }
+    }
+  }
+private:
+  unsigned char *out_;
+  int position_;
+};
+
+/** BC7 block in mode 6, one subset with RGBA endpoints and 4 bit indices. */
+void encode_bc7(const Block &block, unsigned char *out) {
+  static const std::array<int, 16> weights{0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+  glm::vec4 low, high;
+  fit_endpoints(block, glm::vec4(1.0f), low, high);
+
+  // 7 bits per channel plus a shared low bit, picked per endpoint.
+  std::array<glm::ivec4, 2> quantized;
+  std::array<int, 2> p_bits;
+  const std::array<glm::vec4, 2> endpoints{low, high};
+  for (int e = 0; e < 2; e++) {
+    float best_error = std::numeric_limits<float>::max();
+    for (int p = 0; p < 2; p++) {
+      glm::ivec4 q;
+      float error = 0.0f;
+      for (int c = 0; c < 4; c++) {
+        q[c] = glm::clamp(int(std::lround((endpoints[e][c] - p) / 2.0f)), 0, 127);
+        const float d = float((q[c] << 1) | p) - endpoints[e][c];
+        error += d * d;
+      }
+      if (error < best_error) {
+        best_error = error;
+        quantized[e] = q;
+        p_bits[e] = p;
+      }
+    }
+  }
+
+  std::array<glm::ivec4, 2> expanded;
+  for (int e = 0; e < 2; e++) {
+    for (int c = 0; c < 4; c++) {
+      expanded[e][c] = (quantized[e][c] << 1) | p_bits[e];
+    }
+  }
+  std::array<glm::vec4, 16> palette;
+  for (size_t i = 0; i < palette.size(); i++) {
+    for (int c = 0; c < 4; c++) {
+      palette[i][c] = float(((64 - weights[i]) * expanded[0][c] + weights[i] * expanded[1][c] + 32) >> 6);
+    }
+  }
+
+  std::array<uint32_t, 16> indices;
+  for (size_t i = 0; i < block.size(); i++) {
+    uint32_t best = 0;
+    float best_distance = std::numeric_limits<float>::max();
+    for (uint32_t p = 0; p < palette.size(); p++) {
+      const float d = distance2(block[i], palette[p]);
+      if (d < best_distance) {
+        best_distance = d;
+        best = p;
+      }
+    }
+    indices[i] = best;
+  }
+
+  // The first index is stored without its top bit, so it must be below 8.
+  if (indices[0] >= 8) {
+    std::swap(quantized[0], quantized[1]);
+    std::swap(p_bits[0], p_bits[1]);
+    for (auto &index : indices) {
+      index = 15 - index;
+    }
+  }
+
+  BitWriter writer(out);
+  writer.write(1 << 6, 7);
+  for (int c = 0; c < 4; c++) {
+    writer.write(uint32_t(quantized[0][c]), 7);
+    writer.write(uint32_t(quantized[1][c]), 7);
+  }
+  writer.write(uint32_t(p_bits[0]), 1);
+  writer.write(uint32_t(p_bits[1]), 1);
+  writer.write(indices[0], 3);
+  for (size_t i = 1; i < indices.size(); i++) {
+    writer.write(indices[i], 4);
+  }
+}
+}
+
+Texture::Data downsample(const Texture::Data &rgba, const int width, const int height, const MipFilter &filter) {
+  // sRGB to linear, and back with a rounding search over the table.
+  static const auto to_linear = [] {
+    std::array<float, 256> table;
+    for (size_t i = 0; i < table.size(); i++) {
+      const float c = float(i) / 255.0f;
+      table[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+    }
+    return table;
+  }();
+  const auto to_srgb = [](const float linear) {
+    const auto it = std::lower_bound(to_linear.begin(), to_linear.end(), linear);
+    if (it == to_linear.end()) {
+      return uint8_t(255);
+    }
+    if (it != to_linear.begin() && linear - *(it - 1) < *it - linear) {
+      return uint8_t(it - 1 - to_linear.begin());
+    }
+    return uint8_t(it - to_linear.begin());
+  };
+
+  const int half_width = std::max(1, width / 2);
+  const int half_height = std::max(1, height / 2);
+  Texture::Data result(size_t(half_width) * half_height * 4);
+  for (int y = 0; y < half_height; y++) {
+    for (int x = 0; x < half_width; x++) {
+      glm::vec4 sum(0.0f);
+      for (int i = 0; i < 4; i++) {
+        const int source_x = std::min(x * 2 + (i & 1), width - 1);
+        const int source_y = std::min(y * 2 + (i >> 1), height - 1);
+        const auto *pixel = &rgba[(size_t(source_y) * width + source_x) * 4];
+        for (int c = 0; c < 4; c++) {
+          sum[c] += filter == MipFilter::SRGB && c < 3 ? to_linear[pixel[c]] : float(pixel[c]);
+        }
+      }
+      glm::vec4 average = sum / 4.0f;
+      auto *out = &result[(size_t(y) * half_width + x) * 4];
+      if (filter == MipFilter::NORMAL) {
+        glm::vec4 normal = average / 127.5f - glm::vec4(1.0f);
+        normal.w = 0.0f;
+        const float length = glm::length(normal);
+        if (length > 1e-6f) {
+          normal /= length;
+        }
+        average = glm::vec4((normal.x + 1.0f) * 127.5f, (normal.y + 1.0f) * 127.5f,
+                            (normal.z + 1.0f) * 127.5f, average.w);
+      }
+      for (int c = 0; c < 4; c++) {
+        out[c] = filter == MipFilter::SRGB && c < 3
+                 ? to_srgb(average[c])
+                 : uint8_t(glm::clamp(int(std::lround(average[c])), 0, 255));
+      }
+    }
+  }
+  return result;
+}
+
+Texture::Data encode(const Texture::Data &rgba, const int width, const int height, const Texture::Format &format) {
+  if (rgba.size() != size_t(width) * height * 4) {
+    throw std::runtime_error("Texture encoding expects RGBA8 pixels.");
+  }
+  if (!Texture::compressed(format)) {
+    const size_t channels = Texture::size(format, 1, 1);
+    Texture::Data result(size_t(width) * height * channels);
+    for (size_t i = 0; i < size_t(width) * height; i++) {
+      std::copy(&rgba[i * 4], &rgba[i * 4] + channels, &result[i * channels]);
+    }
+    return result;
+  }
+  Texture::Data result(Texture::size(format, width, height));
+  const size_t block_size = Texture::size(format, 4, 4);
+  const int blocks_x = (width + 3) / 4;
+  const int blocks_y = (height + 3) / 4;
+  for (int y = 0; y < blocks_y; y++) {
+    for (int x = 0; x < blocks_x; x++) {
+      const auto block = load_block(rgba, width, height, x, y);
+      auto *out = &result[(size_t(y) * blocks_x + x) * block_size];
+      switch (format) {
+        case Texture::Format::BC1:
+        case Texture::Format::BC1_SRGB:
+          encode_bc1(block, out);
+          break;
+        case Texture::Format::BC3:
+        case Texture::Format::BC3_SRGB:
+          encode_bc4(block, 3, out);
+          encode_bc1(block, out + 8);
+          break;
+        case Texture::Format::BC4:
+          encode_bc4(block, 0, out);
+          break;
+        case Texture::Format::BC5:
+          encode_bc4(block, 0, out);
+          encode_bc4(block, 1, out + 8);
+          break;
+        default:
+          encode_bc7(block, out);
+          break;
+      }
+    }
+  }
+  return result;
+}
+
+SharedTexture2D build_texture(const Texture::Data &rgba,
+                              const int width,
+                              const int height,
+                              const Texture::Format &format,
+                              const MipFilter &filter,
+                              const bool mipmaps,
+                              const Texture::Wrap &wrap) {
+  Texture::Data data;
+  Texture::Data level = rgba;
+  int level_width = width;
+  int level_height = height;
+  int levels = 0;
+  while (true) {
+    const auto encoded = encode(level, level_width, level_height, format);
+    data.insert(data.end(), encoded.begin(), encoded.end());
+    levels++;
+    if (!mipmaps || (level_width == 1 && level_height == 1)) {
+      break;
+    }
+    level = downsample(level, level_width, level_height, filter);
+    level_width = std::max(1, level_width / 2);
+    level_height = std::max(1, level_height / 2);
+  }
+  return std::make_shared<Texture2D>(data.begin(), data.end(), width, height, format, wrap, mipmaps, levels);
+}
+}
+}
@@ -0,0 +1,135 @@
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <glm/gtc/packing.hpp>
+#include <mos/gfx/vertex_layout.hpp>
+
+namespace mos {
+namespace gfx {
+
+namespace {
+size_t component_size(const VertexLayout::Type type) {
+  return type == VertexLayout::Type::FLOAT ? sizeof(float) : sizeof(uint16_t);
+}
+
+/** Unit vector folded onto an octahedron and flattened to [-1, 1]. */
+glm::vec2 octahedral(const glm::vec3 &direction) {
+  const float sum = glm::abs(direction.x) + glm::abs(direction.y) + glm::abs(direction.z);
+  if (sum == 0.0f) {
+    return glm::vec2(0.0f);
+  }
+  const auto n = direction / sum;
+  if (n.z >= 0.0f) {
+    return glm::vec2(n);
+  }
+  const glm::vec2 sign(n.x >= 0.0f ? 1.0f : -1.0f, n.y >= 0.0f ? 1.0f : -1.0f);
+  return (1.0f - glm::abs(glm::vec2(n.y, n.x))) * sign;
+}
+
+void write(const VertexLayout::Attribute &attribute, const float *values, unsigned char *out) {
+  out += attribute.offset;
+  for (int c = 0; c < attribute.components; c++) {
+    switch (attribute.type) {
+      case VertexLayout::Type::FLOAT: {
+        std::memcpy(out + c * sizeof(float), &values[c], sizeof(float));
+        break;
+      }
+      case VertexLayout::Type::HALF: {
+        const uint16_t value = glm::packHalf1x16(values[c]);
+        std::memcpy(out + c * sizeof(value), &value, sizeof(value));
+        break;
+      }
+      case VertexLayout::Type::UNORM16: {
+        const auto value = uint16_t(std::lround(glm::clamp(values[c], 0.0f, 1.0f) * 65535.0f));
+        std::memcpy(out + c * sizeof(value), &value, sizeof(value));
+        break;
+      }
+      case VertexLayout::Type::SNORM16: {
+        const auto value = int16_t(std::lround(glm::clamp(values[c], -1.0f, 1.0f) * 32767.0f));
+        std::memcpy(out + c * sizeof(value), &value, sizeof(value));
+        break;
+      }
+    }
+  }
+}
+}
+
+VertexLayout::VertexLayout(const Position position, const Direction direction, const Uv uv)
+    : position(position), direction(direction), uv(uv) {}
+
+VertexLayout VertexLayout::packed() {
+  return VertexLayout(Position::QUANTIZED, Direction::OCTAHEDRAL, Uv::HALF);
+}
+
+VertexLayout::Attributes VertexLayout::attributes() const {
+  const auto position_type = position == Position::QUANTIZED ? Type::UNORM16 : Type::FLOAT;
+  const auto direction_type = direction == Direction::OCTAHEDRAL ? Type::SNORM16 : Type::FLOAT;
+  const int direction_components = direction == Direction::OCTAHEDRAL ? 2 : 3;
+  const auto uv_type = uv == Uv::HALF ? Type::HALF : Type::FLOAT;
+  Attributes attributes{{{3, position_type, 0},
+                         {direction_components, direction_type, 0},
+                         {direction_components, direction_type, 0},
+                         {2, uv_type, 0},
+                         {1, uv_type, 0}}};
+  // Each attribute is aligned to its component size.
+  size_t offset = 0;
+  for (auto &attribute : attributes) {
+    const auto size = component_size(attribute.type);
+    attribute.offset = (offset + size - 1) / size * size;
+    offset = attribute.offset + attribute.components * size;
+  }
+  return attributes;
+}
+
+size_t VertexLayout::stride() const {
+  const auto last = attributes().back();
+  const auto end = last.offset + last.components * component_size(last.type);
+  return (end + 3) / 4 * 4;
+}
+
+void VertexLayout::pack(const Vertex *vertices,
+                        const size_t count,
+                        const glm::vec3 &min,
+                        const glm::vec3 &max,
+                        void *out) const {
+  static_assert(sizeof(Vertex) == 48, "The float layout is the layout of Vertex.");
+  if (*this == VertexLayout()) {
+    std::memcpy(out, vertices, count * sizeof(Vertex));
+    return;
+  }
+  const auto layout = attributes();
+  const auto size = stride();
+  const auto extent = glm::max(max - min, glm::vec3(std::numeric_limits<float>::min()));
+  auto *bytes = static_cast<unsigned char *>(out);
+  std::memset(bytes, 0, count * size);
+  for (size_t i = 0; i < count; i++) {
+    const auto &vertex = vertices[i];
+    auto *destination = bytes + i * size;
+
+    const auto position_value = position == Position::QUANTIZED ? (vertex.position - min) / extent : vertex.position;
+    write(layout[0], &position_value[0], destination);
+
+    if (direction == Direction::OCTAHEDRAL) {
+      const auto normal = octahedral(vertex.normal);
+      const auto tangent = octahedral(vertex.tangent);
+      write(layout[1], &normal[0], destination);
+      write(layout[2], &tangent[0], destination);
+    } else {
+      write(layout[1], &vertex.normal[0], destination);
+      write(layout[2], &vertex.tangent[0], destination);
+    }
+    write(layout[3], &vertex.uv[0], destination);
+    write(layout[4], &vertex.weight, destination);
+  }
+}
+
+bool VertexLayout::operator==(const VertexLayout &other) const {
+  return position == other.position && direction == other.direction && uv == other.uv;
+}
+
+bool VertexLayout::operator!=(const VertexLayout &other) const {
+  return !(*this == other);
+}
+}
+}
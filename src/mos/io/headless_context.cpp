@@ -0,0 +1,160 @@
+#ifdef MOS_HEADLESS
+#include <stdexcept>
+#include <cstring>
+#include <string>
+#include <glad/glad.h>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <mos/io/headless_context.hpp>
+
+namespace mos {
+namespace io {
+
+static bool has_extension(const char *extensions, const char *name) {
+  return extensions && std::strstr(extensions, name) != nullptr;
+}
+
+static const EGLint context_attributes[] = {
+    EGL_CONTEXT_MAJOR_VERSION, 4,
+    EGL_CONTEXT_MINOR_VERSION, 3,
+    EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+    EGL_NONE};
+
+HeadlessContext::HeadlessContext()
+    : display_(EGL_NO_DISPLAY), config_(nullptr), context_(EGL_NO_CONTEXT),
+      surface_(EGL_NO_SURFACE), shared_context_(EGL_NO_CONTEXT),
+      shared_surface_(EGL_NO_SURFACE) {
+  // The destructor does not run when the constructor throws.
+  try {
+    create();
+  } catch (...) {
+    destroy();
+    throw;
+  }
+}
+
+void HeadlessContext::create() {
+  EGLDisplay display = EGL_NO_DISPLAY;
+  const char *client_extensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+  if (has_extension(client_extensions, "EGL_MESA_platform_surfaceless")) {
+    auto get_platform_display = (PFNEGLGETPLATFORMDISPLAYEXTPROC)
+        eglGetProcAddress("eglGetPlatformDisplayEXT");
+    if (get_platform_display) {
+      display = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA,
+                                     EGL_DEFAULT_DISPLAY, nullptr);
+    }
+  }
+  if (display == EGL_NO_DISPLAY) {
+    display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+  }
+  if (display == EGL_NO_DISPLAY || !eglInitialize(display, nullptr, nullptr)) {
+    throw std::runtime_error("Could not initialize EGL display.");
+  }
+  display_ = display;
+
+  if (!eglBindAPI(EGL_OPENGL_API)) {
+    throw std::runtime_error("EGL does not support desktop OpenGL.");
+  }
+
+  const EGLint config_attributes[] = {
+      EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+      EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+      EGL_RED_SIZE, 8,
+      EGL_GREEN_SIZE, 8,
+      EGL_BLUE_SIZE, 8,
+      EGL_ALPHA_SIZE, 8,
+      EGL_DEPTH_SIZE, 24,
+      EGL_NONE};
+  EGLConfig config;
+  EGLint count = 0;
+  if (!eglChooseConfig(display, config_attributes, &config, 1, &count) ||
+      count == 0) {
+    throw std::runtime_error("No suitable EGL config.");
+  }
+  config_ = config;
+
+  context_ = eglCreateContext(display, config, EGL_NO_CONTEXT,
+                              context_attributes);
+  if (context_ == EGL_NO_CONTEXT) {
+    throw std::runtime_error("Could not create an OpenGL 4.3 EGL context.");
+  }
+
+  const char *extensions = eglQueryString(display, EGL_EXTENSIONS);
+  if (!has_extension(extensions, "EGL_KHR_surfaceless_context")) {
+    const EGLint surface_attributes[] = {EGL_WIDTH, 1, EGL_HEIGHT, 1,
+                                         EGL_NONE};
+    surface_ = eglCreatePbufferSurface(display, config, surface_attributes);
+    if (surface_ == EGL_NO_SURFACE) {
+      throw std::runtime_error("Could not create EGL pbuffer surface.");
+    }
+  }
+
+  make_current();
+
+  if (!gladLoadGLLoader((GLADloadproc) eglGetProcAddress)) {
+    throw std::runtime_error("Could not load OpenGL functions.");
+  }
+}
+
+HeadlessContext::~HeadlessContext() {
+  destroy();
+}
+
+void HeadlessContext::destroy() {
+  if (display_ == EGL_NO_DISPLAY) {
+    return;
+  }
+  eglMakeCurrent(display_, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+  if (shared_surface_ != EGL_NO_SURFACE) {
+    eglDestroySurface(display_, shared_surface_);
+  }
+  if (shared_context_ != EGL_NO_CONTEXT) {
+    eglDestroyContext(display_, shared_context_);
+  }
+  if (surface_ != EGL_NO_SURFACE) {
+    eglDestroySurface(display_, surface_);
+  }
+  if (context_ != EGL_NO_CONTEXT) {
+    eglDestroyContext(display_, context_);
+  }
+  eglTerminate(display_);
+  display_ = EGL_NO_DISPLAY;
+}
+
+void HeadlessContext::make_current() {
+  if (!eglMakeCurrent(display_, surface_, surface_, context_)) {
+    throw std::runtime_error("Could not make EGL context current.");
+  }
+}
+
+std::function<void(bool)> HeadlessContext::shared_context() {
+  if (shared_context_ == EGL_NO_CONTEXT) {
+    shared_context_ = eglCreateContext(display_, config_, context_,
+                                       context_attributes);
+    if (shared_context_ == EGL_NO_CONTEXT) {
+      throw std::runtime_error("Could not create a shared EGL context.");
+    }
+    // A context is current on one thread at a time, so it needs its own surface.
+    if (surface_ != EGL_NO_SURFACE) {
+      const EGLint surface_attributes[] = {EGL_WIDTH, 1, EGL_HEIGHT, 1,
+                                           EGL_NONE};
+      shared_surface_ = eglCreatePbufferSurface(display_, config_, surface_attributes);
+      if (shared_surface_ == EGL_NO_SURFACE) {
+        throw std::runtime_error("Could not create EGL pbuffer surface.");
+      }
+    }
+  }
+  auto display = display_;
+  auto context = shared_context_;
+  auto surface = shared_surface_;
+  return [display, context, surface](const bool current) {
+    if (!current) {
+      eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    } else if (!eglMakeCurrent(display, surface, surface, context)) {
+      throw std::runtime_error("Could not make EGL context current.");
+    }
+  };
+}
+}
+}
+#endif // MOS_HEADLESS
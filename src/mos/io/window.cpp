@@ -1,3 +1,4 @@
+#include <stdexcept>
 #include <iostream>
 #include <mos/io/window.hpp>
 
@@ -65,9 +66,26 @@ Window::Window(const std::string &title, const glm::ivec2 &resolution, const int
 Window::~Window() {
   glfwDestroyCursor(hand_cursor_);
   glfwDestroyCursor(arrow_cursor_);
+  if (shared_window_) {
+    glfwDestroyWindow(shared_window_);
+  }
   glfwDestroyWindow(window_);
 }
 
+std::function<void(bool)> Window::shared_context() {
+  if (!shared_window_) {
+    // Context hints from the constructor still apply.
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    shared_window_ = glfwCreateWindow(1, 1, "", nullptr, window_);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_TRUE);
+    if (!shared_window_) {
+      throw std::runtime_error("Could not create a shared context.");
+    }
+  }
+  auto *window = shared_window_;
+  return [window](const bool current) { glfwMakeContextCurrent(current ? window : nullptr); };
+}
+
 void Window::error_callback(int error, const char *description) {
   if (error_func) {
     error_func(error, std::string(description));
@@ -11,24 +11,28 @@ Box::Box(const glm::vec3 &extent, const glm::vec3 &position)
 
 Box::Box() {}
 
-Box Box::create_from_model(const gfx::Model &model, const glm::mat4 &transform) {
-  std::vector<gfx::Vertex> all_vertices;
-
-  std::function<void(const gfx::Model &, const glm::mat4 &, std::vector<gfx::Vertex> &)>
-      create = [&](const gfx::Model &m, const glm::mat4 &t, std::vector<gfx::Vertex> &v) {
-    if (m.mesh != nullptr) {
-      for (auto &v0 : m.mesh->vertices) {
-        auto vt0 = v0;
-        vt0.position = glm::vec3(t * m.transform * glm::vec4(v0.position, 1.0f));
-        v.push_back(vt0);
-      }
+/** Grow min and max to hold the transformed vertices of a model and its children. */
+static void expand(const gfx::Model &model, const glm::mat4 &parent, bool &empty, glm::vec3 &min, glm::vec3 &max) {
+  const glm::mat4 transform = parent * model.transform;
+  if (model.mesh != nullptr) {
+    for (const auto &vertex : model.mesh->vertices) {
+      const auto position = glm::vec3(transform * glm::vec4(vertex.position, 1.0f));
+      min = empty ? position : glm::min(min, position);
+      max = empty ? position : glm::max(max, position);
+      empty = false;
     }
-    for (auto &child : m.models) {
-      create(child, t * m.transform, v);
-    }
-  };
-  create(model, transform, all_vertices);
-  return Box(all_vertices.begin(), all_vertices.end(), glm::mat4(1.0f));
+  }
+  for (const auto &child : model.models) {
+    expand(child, transform, empty, min, max);
+  }
+}
+
+Box Box::create_from_model(const gfx::Model &model, const glm::mat4 &transform) {
+  bool empty = true;
+  glm::vec3 min(0.0f);
+  glm::vec3 max(0.0f);
+  expand(model, transform, empty, min, max);
+  return create_from_min_max(min, max);
 }
 
 Box Box::create_from_min_max(const glm::vec3 &min, const glm::vec3 &max) {
@@ -83,6 +87,35 @@ bool Box::intersects(const Ray &ray) const {
   return intersects(ray.origin, ray.direction());
 }
 
+bool Box::intersects_segment(const glm::vec3 &start,
+                             const glm::vec3 &end) const {
+  const auto direction = end - start;
+  const auto bounds_min = min();
+  const auto bounds_max = max();
+  float tmin = 0.0f;
+  float tmax = 1.0f;
+  for (int i = 0; i < 3; i++) {
+    if (glm::abs(direction[i]) < 1e-8f) {
+      if (start[i] < bounds_min[i] || start[i] > bounds_max[i]) {
+        return false;
+      }
+    } else {
+      const float invdir = 1.0f / direction[i];
+      float t0 = (bounds_min[i] - start[i]) * invdir;
+      float t1 = (bounds_max[i] - start[i]) * invdir;
+      if (t0 > t1) {
+        std::swap(t0, t1);
+      }
+      tmin = glm::max(tmin, t0);
+      tmax = glm::min(tmax, t1);
+      if (tmin > tmax) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
 void Box::transform(const glm::mat4 &transform) {
   position.x = transform[3][0];
   position.y = transform[3][1];
@@ -43,6 +43,23 @@ Navmesh::closest_intersection(const glm::vec3 &origin,
   return closest;
 }
 
+bool Navmesh::intersects_segment(const glm::vec3 &start,
+                                 const glm::vec3 &end) const {
+  const auto direction = end - start;
+  for (const auto &triangle : triangles) {
+    glm::vec3 bary;
+    // With an unnormalized direction, bary.z is the fraction of the segment.
+    if (glm::intersectRayTriangle(start, direction,
+                                  vertices[triangle[0]].position,
+                                  vertices[triangle[1]].position,
+                                  vertices[triangle[2]].position, bary) &&
+        bary.z <= 1.0f) {
+      return true;
+    }
+  }
+  return false;
+}
+
 Navmesh::~Navmesh() {}
 void Navmesh::calculate_normals() {
   for (size_t i = 0; i < triangles.size(); i++) {
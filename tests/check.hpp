@@ -0,0 +1,12 @@
+#pragma once
+#include <cstdio>
+#include <cstdlib>
+
+/** Exit with a message when a condition does not hold, for test executables run by ctest. */
+#define MOS_CHECK(condition)                                                      \
+  do {                                                                            \
+    if (!(condition)) {                                                           \
+      std::fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+      std::exit(EXIT_FAILURE);                                                    \
+    }                                                                             \
+  } while (false)
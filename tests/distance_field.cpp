@@ -0,0 +1,48 @@
+#include <glm/glm.hpp>
+#include <mos/gfx/distance_field.hpp>
+#include "check.hpp"
+
+using namespace mos::gfx;
+
+static bool near(const glm::vec2 &a, const glm::vec2 &b) {
+  return glm::all(glm::lessThan(glm::abs(a - b), glm::vec2(1e-6f)));
+}
+
+int main() {
+  const int width = 64;
+  const int height = 32;
+  Texture::Data pixels(size_t(width) * height * 4, 0);
+  Character character{1.0f, 2.0f, 18.0f, 16.0f, 8.0f, 4.0f, 20.0f, 'A'};
+  for (int y = 6; y < 20; y++) {
+    for (int x = 10; x < 22; x++) {
+      pixels[(size_t(y) * width + x) * 4 + 3] = 255;
+    }
+  }
+  auto atlas = std::make_shared<Texture2D>(pixels.begin(), pixels.end(), width, height,
+                                           Texture::Format::RGBA, Texture::Wrap::CLAMP, false);
+  const Font font({{'A', character}}, atlas, 24.0f, 20.0f, 0.0f);
+  const auto sdf = distance_field_font(font, 4, 4.0f);
+
+  const auto &bitmap_glyph = font.glyph('A');
+  const auto &sdf_glyph = sdf.glyph('A');
+  MOS_CHECK(sdf_glyph.valid);
+  MOS_CHECK(near(bitmap_glyph.uv_min, sdf_glyph.uv_min));
+  MOS_CHECK(near(bitmap_glyph.uv_max, sdf_glyph.uv_max));
+  MOS_CHECK(near(bitmap_glyph.size, sdf_glyph.size));
+  MOS_CHECK(near(bitmap_glyph.offset, sdf_glyph.offset));
+  MOS_CHECK(glm::abs(bitmap_glyph.advance - sdf_glyph.advance) < 1e-6f);
+
+  // Coverage inside the glyph rectangle spans source texels 10 to 19 by 6 to 18.
+  const auto &atlas_texels = sdf.texture->layers[0];
+  const auto distance = [&](const int x, const int y) {
+    return int(atlas_texels[size_t(y) * size_t(sdf.texture->width()) + x]);
+  };
+  MOS_CHECK(sdf.texture->width() == width / 4 && sdf.texture->height() == height / 4);
+  // Centred on source texel (14, 10), four texels from the nearest edge.
+  MOS_CHECK(distance(3, 2) > 128);
+  // Centred on (2, 2), farther than the spread from any coverage.
+  MOS_CHECK(distance(0, 0) < 128);
+  // Centred on (10, 10), on the left edge.
+  MOS_CHECK(glm::abs(distance(2, 2) - 128) <= 8);
+  return 0;
+}
@@ -0,0 +1,145 @@
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <new>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include <mos/core/jobs.hpp>
+#include "check.hpp"
+
+using namespace mos;
+
+/** Heap allocations made by the whole program. */
+static std::atomic_size_t allocations{0};
+
+void *operator new(const size_t size) {
+  allocations++;
+  if (void *pointer = std::malloc(size > 0 ? size : 1)) {
+    return pointer;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void *pointer) noexcept {
+  std::free(pointer);
+}
+
+void operator delete(void *pointer, size_t) noexcept {
+  std::free(pointer);
+}
+
+/** Every index is visited once, for ranges that do and do not divide evenly. */
+static void parallel_for_covers_range() {
+  for (const size_t grain : {size_t(1), size_t(7), size_t(1000), size_t(200000)}) {
+    std::vector<int> visits(100003, 0);
+    Jobs::parallel_for(0, visits.size(), grain, [&](const size_t begin, const size_t end) {
+      MOS_CHECK(end - begin <= grain);
+      for (size_t i = begin; i < end; i++) {
+        visits[i]++;
+      }
+    });
+    for (const auto count : visits) {
+      MOS_CHECK(count == 1);
+    }
+  }
+  bool called = false;
+  Jobs::parallel_for(5, 5, 1, [&](size_t, size_t) { called = true; });
+  MOS_CHECK(!called);
+}
+
+/** A dependent job runs after every job of its dependency. */
+static void run_after_orders() {
+  JobCounter first;
+  JobCounter second;
+  std::atomic_int done{0};
+  int seen = -1;
+  for (int i = 0; i < 4; i++) {
+    Jobs::run([&]() {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      done++;
+    }, first);
+  }
+  Jobs::run_after(first, [&]() { seen = done.load(); }, second);
+  Jobs::wait(second);
+  MOS_CHECK(seen == 4);
+
+  // A finished dependency runs the job right away.
+  JobCounter third;
+  bool ran = false;
+  Jobs::run_after(first, [&]() { ran = true; }, third);
+  Jobs::wait(third);
+  MOS_CHECK(ran);
+}
+
+/** The first exception of a job is rethrown by wait, once. */
+static void exceptions_propagate() {
+  JobCounter counter;
+  Jobs::run([]() { throw std::runtime_error("job"); }, counter);
+  Jobs::run([]() {}, counter);
+  bool caught = false;
+  try {
+    Jobs::wait(counter);
+  } catch (const std::runtime_error &) {
+    caught = true;
+  }
+  MOS_CHECK(caught);
+  Jobs::wait(counter);
+
+  caught = false;
+  try {
+    Jobs::parallel_for(0, 100, 1, [](const size_t begin, size_t) {
+      if (begin == 50) {
+        throw std::runtime_error("range");
+      }
+    });
+  } catch (const std::runtime_error &) {
+    caught = true;
+  }
+  MOS_CHECK(caught);
+}
+
+/** Jobs that wait on other jobs do not deadlock the pool. */
+static void nested_waits() {
+  std::atomic_int count{0};
+  Jobs::parallel_for(0, 64, 1, [&](size_t, size_t) {
+    Jobs::parallel_for(0, 64, 1, [&](size_t, size_t) { count++; });
+  });
+  MOS_CHECK(count == 64 * 64);
+
+  JobCounter outer;
+  for (int i = 0; i < 16; i++) {
+    Jobs::run([&]() {
+      JobCounter inner;
+      for (int j = 0; j < 16; j++) {
+        Jobs::run([&]() { count++; }, inner);
+      }
+      Jobs::wait(inner);
+    }, outer);
+  }
+  Jobs::wait(outer);
+  MOS_CHECK(count == 64 * 64 + 16 * 16);
+}
+
+/** Once the queues have grown, queuing ranges does not touch the heap. */
+static void parallel_for_does_not_allocate() {
+  std::atomic_size_t sum{0};
+  const auto add = [&](const size_t begin, const size_t end) { sum += end - begin; };
+  for (int i = 0; i < 3; i++) {
+    Jobs::parallel_for(0, 5000, 1, add);
+  }
+  allocations = 0;
+  Jobs::parallel_for(0, 5000, 1, add);
+  MOS_CHECK(allocations == 0);
+  MOS_CHECK(sum == 4 * 5000);
+}
+
+int main() {
+  MOS_CHECK(Jobs::workers() > 0);
+  parallel_for_covers_range();
+  parallel_for_does_not_allocate();
+  run_after_orders();
+  exceptions_propagate();
+  nested_waits();
+  return 0;
+}
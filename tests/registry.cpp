@@ -0,0 +1,120 @@
+#include <stdexcept>
+#include <string>
+#include <mos/core/registry.hpp>
+#include "check.hpp"
+
+using namespace mos;
+
+/** Lookups by id and by handle, and insert against insert_or_assign. */
+static void lookups() {
+  Registry<std::string> registry;
+  const auto handle = registry.insert(7, "seven");
+  MOS_CHECK(handle.valid());
+  MOS_CHECK(registry.size() == 1);
+  MOS_CHECK(registry.contains(7) && !registry.contains(8));
+  MOS_CHECK(*registry.get(handle) == "seven");
+  MOS_CHECK(registry.at(7) == "seven");
+  MOS_CHECK(registry.find(8) == nullptr);
+  MOS_CHECK(!registry.handle(8).valid());
+
+  // Insert keeps the present value, insert_or_assign replaces it.
+  const auto again = registry.insert(7, "other");
+  MOS_CHECK(again.index == handle.index && again.generation == handle.generation);
+  MOS_CHECK(registry.at(7) == "seven");
+  registry.insert_or_assign(7, "replaced");
+  MOS_CHECK(registry.at(7) == "replaced");
+
+  bool thrown = false;
+  try {
+    registry.at(8);
+  } catch (const std::out_of_range &) {
+    thrown = true;
+  }
+  MOS_CHECK(thrown);
+}
+
+/** A handle goes stale when its entry is erased, and stays stale after the slot is reused. */
+static void stale_handles() {
+  Registry<int> registry;
+  const auto handle = registry.insert(1, 10);
+  MOS_CHECK(registry.erase(1));
+  MOS_CHECK(!registry.erase(1));
+  MOS_CHECK(registry.get(handle) == nullptr);
+  MOS_CHECK(registry.size() == 0);
+
+  const auto reused = registry.insert(2, 20);
+  MOS_CHECK(reused.index == handle.index);
+  MOS_CHECK(reused.generation != handle.generation);
+  MOS_CHECK(registry.get(handle) == nullptr);
+  MOS_CHECK(*registry.get(reused) == 20);
+
+  // Inserting the erased id again gives a new handle too.
+  const auto inserted = registry.insert(1, 30);
+  MOS_CHECK(registry.get(handle) == nullptr);
+  MOS_CHECK(*registry.get(inserted) == 30);
+}
+
+/** Pages are freed with their last id, and the page table shrinks to the live ids. */
+static void pages_follow_live_ids() {
+  Registry<int> registry;
+  MOS_CHECK(registry.index_bytes() == 0);
+  registry.insert(0, 0);
+  const auto one_page = registry.index_bytes();
+  MOS_CHECK(one_page > 0);
+
+  // Ids far apart keep only the table between them.
+  registry.insert(5000000, 1);
+  MOS_CHECK(registry.index_bytes() > 2 * one_page);
+  registry.erase(0);
+  MOS_CHECK(registry.index_bytes() == one_page);
+  MOS_CHECK(registry.at(5000000) == 1);
+
+  // Growing ids with old ones erased, like resources loaded and released over time.
+  for (unsigned int id = 5000001; id < 5100000; id++) {
+    registry.insert(id, int(id));
+    registry.erase(id - 1);
+  }
+  MOS_CHECK(registry.size() == 1);
+  MOS_CHECK(registry.index_bytes() == one_page);
+
+  // An id below the first page grows the table at the front.
+  registry.insert(3, 3);
+  MOS_CHECK(registry.at(3) == 3 && registry.at(5099999) == 5099999);
+  registry.erase(5099999);
+  MOS_CHECK(registry.index_bytes() == one_page);
+  registry.erase(3);
+  MOS_CHECK(registry.index_bytes() == 0);
+}
+
+/** Clear erases every entry and its handles. */
+static void clear_erases_all() {
+  Registry<int> registry;
+  Handle handles[3];
+  for (unsigned int id = 0; id < 3; id++) {
+    handles[id] = registry.insert(id * 10000, int(id));
+  }
+  int visited = 0;
+  registry.for_each([&](const unsigned int id, int &value) {
+    MOS_CHECK(id == unsigned(value) * 10000);
+    visited++;
+  });
+  MOS_CHECK(visited == 3);
+
+  registry.clear();
+  MOS_CHECK(registry.size() == 0);
+  MOS_CHECK(registry.index_bytes() == 0);
+  for (unsigned int id = 0; id < 3; id++) {
+    MOS_CHECK(!registry.contains(id * 10000));
+    MOS_CHECK(registry.get(handles[id]) == nullptr);
+  }
+  registry.insert(10000, 5);
+  MOS_CHECK(registry.at(10000) == 5);
+}
+
+int main() {
+  lookups();
+  stale_handles();
+  pages_follow_live_ids();
+  clear_erases_all();
+  return 0;
+}
@@ -0,0 +1,96 @@
+/**
+ * Offline texture compression and mip generation.
+ *
+ * texture_compress <input.png> <output.texture> [--type color|normal|mask]
+ *                  [--format bc1|bc3|bc4|bc5|bc7|r|rg|rgb|rgba] [--linear] [--no-mipmaps]
+ *
+ * Colour maps default to BC7 in sRGB, normal maps to BC5 and single channel
+ * masks, like roughness, metallic and ambient occlusion, to BC4. Mip levels
+ * of colour maps are filtered in linear space, and normal maps are
+ * renormalized.
+ */
+#include <iostream>
+#include <map>
+#include <string>
+#include <stdexcept>
+#include <stb_image.h>
+#include <mos/gfx/texture_encoder.hpp>
+
+using mos::gfx::Texture;
+
+int main(int argc, char *argv[]) {
+  if (argc < 3) {
+    std::cerr << "Usage: " << argv[0]
+              << " <input.png> <output.texture> [--type color|normal|mask]"
+                 " [--format bc1|bc3|bc4|bc5|bc7|r|rg|rgb|rgba] [--linear] [--no-mipmaps]" << std::endl;
+    return 1;
+  }
+  const std::string input = argv[1];
+  const std::string output = argv[2];
+  std::string type = "color";
+  std::string format_name;
+  bool linear = false;
+  bool mipmaps = true;
+  for (int i = 3; i < argc; i++) {
+    const std::string argument = argv[i];
+    if (argument == "--type" && i + 1 < argc) {
+      type = argv[++i];
+    } else if (argument == "--format" && i + 1 < argc) {
+      format_name = argv[++i];
+    } else if (argument == "--linear") {
+      linear = true;
+    } else if (argument == "--no-mipmaps") {
+      mipmaps = false;
+    } else {
+      std::cerr << "Unknown argument " << argument << std::endl;
+      return 1;
+    }
+  }
+
+  const std::map<std::string, std::string> default_formats{{"color", "bc7"}, {"normal", "bc5"}, {"mask", "bc4"}};
+  if (format_name.empty()) {
+    if (default_formats.find(type) == default_formats.end()) {
+      std::cerr << "Unknown texture type " << type << std::endl;
+      return 1;
+    }
+    format_name = default_formats.at(type);
+  }
+  // Only colour is stored in sRGB.
+  const bool srgb = type == "color" && !linear;
+  const std::map<std::string, Texture::Format> formats{
+      {"bc1", srgb ? Texture::Format::BC1_SRGB : Texture::Format::BC1},
+      {"bc3", srgb ? Texture::Format::BC3_SRGB : Texture::Format::BC3},
+      {"bc4", Texture::Format::BC4},
+      {"bc5", Texture::Format::BC5},
+      {"bc7", srgb ? Texture::Format::BC7_SRGB : Texture::Format::BC7},
+      {"r", Texture::Format::R},
+      {"rg", Texture::Format::RG},
+      {"rgb", srgb ? Texture::Format::SRGB : Texture::Format::RGB},
+      {"rgba", srgb ? Texture::Format::SRGBA : Texture::Format::RGBA}};
+  if (formats.find(format_name) == formats.end()) {
+    std::cerr << "Unknown format " << format_name << std::endl;
+    return 1;
+  }
+
+  int width, height, channels;
+  unsigned char *pixels = stbi_load(input.c_str(), &width, &height, &channels, 4);
+  if (!pixels) {
+    std::cerr << "Could not load " << input << std::endl;
+    return 1;
+  }
+  const Texture::Data rgba(pixels, pixels + size_t(width) * height * 4);
+  stbi_image_free(pixels);
+
+  try {
+    const auto filter = type == "normal" ? mos::gfx::MipFilter::NORMAL
+                                         : srgb ? mos::gfx::MipFilter::SRGB : mos::gfx::MipFilter::LINEAR;
+    auto texture = mos::gfx::build_texture(rgba, width, height, formats.at(format_name), filter, mipmaps);
+    texture->save(output);
+    std::cout << input << " -> " << output << " (" << format_name << ", "
+              << texture->levels << " levels, " << texture->layers[0].size() << " bytes)" << std::endl;
+  } catch (const std::exception &e) {
+    std::cerr << e.what() << std::endl;
+    return 1;
+  }
+  return 0;
+}